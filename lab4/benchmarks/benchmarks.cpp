@@ -0,0 +1,188 @@
+#include <benchmark/benchmark.h>
+
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <streambuf>
+#include <string>
+
+#include "array.h"
+#include "figure.h"
+#include "point.h"
+#include "rhombus.h"
+#include "trapezoid.h"
+#include "pentagon.h"
+
+using namespace std;
+
+// Запуск: ./benchmarks --benchmark_format=json --benchmark_out=run.json
+
+template <Scalar T>
+shared_ptr<Figure<T>> makeFigure(size_t i) {
+    T s = static_cast<T>(i % 7 + 1);
+    switch (i % 3) {
+        case 0:
+            return make_shared<Rhombus<T>>(Point<T>(0, 0), Point<T>(s, 1), Point<T>(0, 2), Point<T>(-s, 1));
+        case 1:
+            return make_shared<Trapezoid<T>>(Point<T>(-s, 0), Point<T>(s, 0), Point<T>(1, s), Point<T>(-1, s));
+        default:
+            return make_shared<Pentagon<T>>(Point<T>(0, 0), Point<T>(s, 0), Point<T>(s, s),
+                                            Point<T>(1, s + 1), Point<T>(0, s));
+    }
+}
+
+template <Scalar T>
+Array<T> makeArray(size_t n) {
+    Array<T> array;
+    for (size_t i = 0; i < n; ++i)
+        array.addFigure(makeFigure<T>(i));
+    return array;
+}
+
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+template <Scalar T>
+static void BM_Construct(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        Array<T> array = makeArray<T>(n);
+        benchmark::DoNotOptimize(array.getSize());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// То же, что BM_Construct, но через reserve и emplaceFigure.
+template <Scalar T>
+static void BM_Emplace(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        Array<T> array;
+        array.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            T s = static_cast<T>(i % 7 + 1);
+            switch (i % 3) {
+                case 0:
+                    array.template emplaceFigure<Rhombus<T>>(Point<T>(0, 0), Point<T>(s, 1), Point<T>(0, 2), Point<T>(-s, 1));
+                    break;
+                case 1:
+                    array.template emplaceFigure<Trapezoid<T>>(Point<T>(-s, 0), Point<T>(s, 0), Point<T>(1, s), Point<T>(-1, s));
+                    break;
+                default:
+                    array.template emplaceFigure<Pentagon<T>>(Point<T>(0, 0), Point<T>(s, 0), Point<T>(s, s),
+                                                              Point<T>(1, s + 1), Point<T>(0, s));
+                    break;
+            }
+        }
+        benchmark::DoNotOptimize(array.getSize());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <Scalar T>
+static void BM_GetAllArea(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    Array<T> array = makeArray<T>(n);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(array.getAllArea());
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <Scalar T>
+static void BM_ArrayCopy(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    Array<T> array = makeArray<T>(n);
+    for (auto _ : state) {
+        Array<T> copy = array;
+        benchmark::DoNotOptimize(copy.getSize());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Удаление из середины и добавление обратно: размер массива не меняется.
+template <Scalar T>
+static void BM_RemoveChurn(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    const size_t ops = min<size_t>(n, 1000);
+    Array<T> array = makeArray<T>(n);
+    auto figure = makeFigure<T>(0);
+    for (auto _ : state) {
+        for (size_t k = 0; k < ops; ++k) {
+            array.removeFigure(array.getSize() / 2);
+            array.addFigure(figure);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * ops);
+}
+
+template <Scalar T>
+static void BM_Print(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    Array<T> array = makeArray<T>(n);
+    size_t bytes = 0;
+    for (auto _ : state) {
+        ostringstream out;
+        for (const auto& figure : array)
+            figure->print(out);
+        bytes += out.str().size();
+    }
+    state.SetBytesProcessed(bytes);
+}
+
+template <Scalar T>
+static void BM_Read(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    ostringstream text;
+    for (size_t i = 0; i < n; ++i) {
+        auto figure = makeFigure<T>(i * 3);
+        const Point<T>* p = figure->getPoints();
+        for (size_t k = 0; k < figure->getSize(); ++k)
+            text << p[k].x << ' ' << p[k].y << ' ';
+    }
+    const string input = text.str();
+
+    NullBuffer sink;
+    streambuf* saved = cout.rdbuf(&sink);
+    for (auto _ : state) {
+        istringstream in(input);
+        Rhombus<T> rhombus;
+        for (size_t i = 0; i < n; ++i)
+            in >> rhombus;
+        benchmark::DoNotOptimize(rhombus.getPoints());
+    }
+    cout.rdbuf(saved);
+    state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+template <Scalar T>
+static void BM_Equality(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    Array<T> left = makeArray<T>(n);
+    Array<T> right = left;
+    for (auto _ : state) {
+        size_t equal = 0;
+        for (size_t i = 0; i < n; ++i)
+            equal += *left.begin()[i] == *right.begin()[i];
+        benchmark::DoNotOptimize(equal);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+#define LAB4_BENCHMARK(name)                                                        \
+    BENCHMARK_TEMPLATE(name, int)->RangeMultiplier(10)->Range(100, 10'000'000);     \
+    BENCHMARK_TEMPLATE(name, float)->RangeMultiplier(10)->Range(100, 10'000'000);   \
+    BENCHMARK_TEMPLATE(name, double)->RangeMultiplier(10)->Range(100, 10'000'000)
+
+LAB4_BENCHMARK(BM_Construct);
+LAB4_BENCHMARK(BM_Emplace);
+LAB4_BENCHMARK(BM_GetAllArea);
+LAB4_BENCHMARK(BM_ArrayCopy);
+LAB4_BENCHMARK(BM_RemoveChurn);
+LAB4_BENCHMARK(BM_Print);
+LAB4_BENCHMARK(BM_Read);
+LAB4_BENCHMARK(BM_Equality);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#include "area_kernel.h"
+#include "point.h"
+
+using namespace std;
+
+// Аффинное преобразование плоскости:
+//   x' = a * x + b * y + tx
+//   y' = c * x + d * y + ty
+// Вычисления ведутся в double; для целых T результат округляется до ближайшего.
+struct Affine2D {
+    double a = 1.0, b = 0.0, tx = 0.0;
+    double c = 0.0, d = 1.0, ty = 0.0;
+
+    static constexpr Affine2D identity() {
+        return {};
+    }
+
+    static constexpr Affine2D translation(double dx, double dy) {
+        return {1.0, 0.0, dx, 0.0, 1.0, dy};
+    }
+
+    static constexpr Affine2D scaling(double sx, double sy) {
+        return {sx, 0.0, 0.0, 0.0, sy, 0.0};
+    }
+
+    static constexpr Affine2D scaling(double sx, double sy, double cx, double cy) {
+        return translation(-cx, -cy).then(scaling(sx, sy)).then(translation(cx, cy));
+    }
+
+    // Поворот против часовой стрелки на angle радиан вокруг начала координат.
+    static Affine2D rotation(double angle) {
+        const double cs = cos(angle), sn = sin(angle);
+        return {cs, -sn, 0.0, sn, cs, 0.0};
+    }
+
+    static Affine2D rotation(double angle, double cx, double cy) {
+        return translation(-cx, -cy).then(rotation(angle)).then(translation(cx, cy));
+    }
+
+    // Сначала *this, затем next.
+    constexpr Affine2D then(const Affine2D& next) const {
+        return {next.a * a + next.b * c, next.a * b + next.b * d, next.a * tx + next.b * ty + next.tx,
+                next.c * a + next.d * c, next.c * b + next.d * d, next.c * tx + next.d * ty + next.ty};
+    }
+
+    constexpr double det() const {
+        return a * d - b * c;
+    }
+
+    constexpr bool isTranslation() const {
+        return a == 1.0 && b == 0.0 && c == 0.0 && d == 1.0;
+    }
+
+    // Поворот с равномерным масштабом (возможно, с отражением): сохраняет форму фигуры.
+    constexpr bool isSimilarity() const {
+        return (a == d && b == -c) || (a == -d && b == c);
+    }
+
+    // Оси переходят в оси: ограничивающий прямоугольник переходит в прямоугольник.
+    constexpr bool isAxisAligned() const {
+        return b == 0.0 && c == 0.0;
+    }
+
+    template <Scalar T>
+    static constexpr T toCoord(double v) {
+        if constexpr (is_integral_v<T>)
+            return static_cast<T>(v < 0 ? v - 0.5 : v + 0.5);
+        else
+            return static_cast<T>(v);
+    }
+
+    template <Scalar T>
+    constexpr Point<T> apply(const Point<T>& p) const {
+        const double x = static_cast<double>(p.x), y = static_cast<double>(p.y);
+        return Point<T>(toCoord<T>(a * x + b * y + tx), toCoord<T>(c * x + d * y + ty));
+    }
+};
+
+namespace affine_detail {
+
+// Хвост после avx2Affine и путь для целых T. Для float/double вычисляется
+// (a * x + b * y) + tx в double с тем же округлением при сужении до T, что и
+// в avx2Affine, поэтому точка не зависит от того, какой путь её обработал.
+template <Scalar T>
+void scalarAffine(T* xs, T* ys, size_t from, size_t count, const Affine2D& m) {
+    for (size_t i = from; i < count; ++i) {
+        const double x = static_cast<double>(xs[i]), y = static_cast<double>(ys[i]);
+        xs[i] = Affine2D::toCoord<T>(m.a * x + m.b * y + m.tx);
+        ys[i] = Affine2D::toCoord<T>(m.c * x + m.d * y + m.ty);
+    }
+}
+
+#if defined(LAB4_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+
+template <typename T>
+__attribute__((target("avx2")))
+size_t avx2Affine(T* xs, T* ys, size_t count, const Affine2D& m) {
+    const __m256d a = _mm256_set1_pd(m.a), b = _mm256_set1_pd(m.b), tx = _mm256_set1_pd(m.tx);
+    const __m256d c = _mm256_set1_pd(m.c), d = _mm256_set1_pd(m.d), ty = _mm256_set1_pd(m.ty);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d x, y;
+        if constexpr (is_same_v<T, double>) {
+            x = _mm256_loadu_pd(xs + i);
+            y = _mm256_loadu_pd(ys + i);
+        } else {
+            x = _mm256_cvtps_pd(_mm_loadu_ps(xs + i));
+            y = _mm256_cvtps_pd(_mm_loadu_ps(ys + i));
+        }
+        const __m256d nx = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(a, x), _mm256_mul_pd(b, y)), tx);
+        const __m256d ny = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(c, x), _mm256_mul_pd(d, y)), ty);
+        if constexpr (is_same_v<T, double>) {
+            _mm256_storeu_pd(xs + i, nx);
+            _mm256_storeu_pd(ys + i, ny);
+        } else {
+            _mm_storeu_ps(xs + i, _mm256_cvtpd_ps(nx));
+            _mm_storeu_ps(ys + i, _mm256_cvtpd_ps(ny));
+        }
+    }
+    return i;
+}
+
+#endif
+
+}
+
+// Применяет m к count точкам с координатами xs[i], ys[i] на месте.
+template <Scalar T>
+void batchAffine(T* xs, T* ys, size_t count, const Affine2D& m, SimdLevel level = detectSimdLevel()) {
+    size_t done = 0;
+#if defined(LAB4_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+    if constexpr (hasSimdAreaKernel<T>) {
+        if (level == SimdLevel::AVX2)
+            done = affine_detail::avx2Affine<T>(xs, ys, count, m);
+    }
+#endif
+    affine_detail::scalarAffine<T>(xs, ys, done, count, m);
+}
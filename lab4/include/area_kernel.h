@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LAB4_X86_SIMD 1
+#endif
+
+#include "point.h"
+
+using namespace std;
+
+enum class SimdLevel {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+inline SimdLevel detectSimdLevel() {
+#if defined(LAB4_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+    static const SimdLevel level = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+        if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+        return SimdLevel::Scalar;
+    }();
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+// Целые координаты считаются точно в скалярном цикле (ScalarTraits<T>::Wide),
+// векторные пути — только для вещественных типов.
+template <typename T>
+inline constexpr bool hasSimdAreaKernel = is_same_v<T, double> || is_same_v<T, float>;
+
+namespace area_kernel_detail {
+
+// Порядок операций совпадает с векторными путями, поэтому результаты побитно равны.
+template <Scalar T, size_t N>
+void scalarArea(const T* const* xs, const T* const* ys, size_t from, size_t count, double* out) {
+    using Wide = typename ScalarTraits<T>::Wide;
+    for (size_t i = from; i < count; ++i) {
+        Wide a = 0;
+        for (size_t k = 0; k < N; ++k) {
+            const size_t next = k + 1 == N ? 0 : k + 1;
+            a += (static_cast<Wide>(xs[k][i]) * static_cast<Wide>(ys[next][i]) -
+                  static_cast<Wide>(xs[next][i]) * static_cast<Wide>(ys[k][i]));
+        }
+        out[i] = static_cast<double>(a < 0 ? -a : a) / 2.0;
+    }
+}
+
+#if defined(LAB4_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+
+template <typename T>
+__attribute__((target("avx2"))) inline __m256d load4(const T* p) {
+    if constexpr (is_same_v<T, double>)
+        return _mm256_loadu_pd(p);
+    else
+        return _mm256_cvtps_pd(_mm_loadu_ps(p));
+}
+
+template <typename T, size_t N>
+__attribute__((target("avx2")))
+size_t avx2Area(const T* const* xs, const T* const* ys, size_t count, double* out) {
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d x[N], y[N];
+        for (size_t k = 0; k < N; ++k) {
+            x[k] = load4(xs[k] + i);
+            y[k] = load4(ys[k] + i);
+        }
+        __m256d a = _mm256_setzero_pd();
+        for (size_t k = 0; k < N; ++k) {
+            const size_t next = k + 1 == N ? 0 : k + 1;
+            a = _mm256_add_pd(a, _mm256_sub_pd(_mm256_mul_pd(x[k], y[next]),
+                                               _mm256_mul_pd(x[next], y[k])));
+        }
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_andnot_pd(signMask, a), half));
+    }
+    return i;
+}
+
+template <typename T>
+__attribute__((target("sse2"))) inline __m128d load2(const T* p) {
+    if constexpr (is_same_v<T, double>) {
+        return _mm_loadu_pd(p);
+    } else {
+        // Два float копируются через memcpy: чтение их как double нарушает strict aliasing.
+        double pair;
+        memcpy(&pair, p, sizeof(pair));
+        return _mm_cvtps_pd(_mm_castpd_ps(_mm_set_sd(pair)));
+    }
+}
+
+template <typename T, size_t N>
+__attribute__((target("sse2")))
+size_t sse2Area(const T* const* xs, const T* const* ys, size_t count, double* out) {
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d x[N], y[N];
+        for (size_t k = 0; k < N; ++k) {
+            x[k] = load2(xs[k] + i);
+            y[k] = load2(ys[k] + i);
+        }
+        __m128d a = _mm_setzero_pd();
+        for (size_t k = 0; k < N; ++k) {
+            const size_t next = k + 1 == N ? 0 : k + 1;
+            a = _mm_add_pd(a, _mm_sub_pd(_mm_mul_pd(x[k], y[next]),
+                                         _mm_mul_pd(x[next], y[k])));
+        }
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_andnot_pd(signMask, a), half));
+    }
+    return i;
+}
+
+#endif
+
+}
+
+// xs[k], ys[k] — координаты k-й вершины для count многоугольников подряд.
+template <Scalar T, size_t N>
+void batchShoelaceArea(const T* const* xs, const T* const* ys, size_t count, double* out,
+                       SimdLevel level = detectSimdLevel()) {
+    static_assert(N >= 3, "polygon needs at least 3 vertices");
+    size_t done = 0;
+#if defined(LAB4_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+    if constexpr (hasSimdAreaKernel<T>) {
+        if (level == SimdLevel::AVX2)
+            done = area_kernel_detail::avx2Area<T, N>(xs, ys, count, out);
+        else if (level == SimdLevel::SSE2)
+            done = area_kernel_detail::sse2Area<T, N>(xs, ys, count, out);
+    }
+#endif
+    area_kernel_detail::scalarArea<T, N>(xs, ys, done, count, out);
+}
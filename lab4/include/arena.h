@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "figure.h"
+
+using namespace std;
+
+// Фигуры размещаются подряд в больших блоках (slab) и освобождаются все сразу.
+// make() возвращает shared_ptr с настоящим счётчиком ссылок: блок управления лежит
+// в том же slab, а удалитель ничего не освобождает, только отмечает, что ссылок больше нет.
+// Поэтому use_count() и копирование при записи в Array работают как обычно,
+// а release() отказывается освобождать память, пока на фигуры арены есть ссылки.
+// Арена должна пережить все shared_ptr из make(): удалитель и блок управления живут
+// в её памяти, поэтому деструктор при живых фигурах завершает программу (terminate).
+// Фигуры с фиксированным числом вершин хранят их внутри себя и не владеют памятью,
+// поэтому их деструкторы не вызываются и release() не обходит фигуры.
+template <Scalar T>
+class FigureArena {
+private:
+    struct DestroyRecord {
+        DestroyRecord* next;
+        void (*destroy)(void*);
+        void* object;
+    };
+
+    struct Slab {
+        unique_ptr<byte[]> data;
+        size_t size;
+    };
+
+    // Размещает блоки управления shared_ptr в slab; память возвращается вместе с ареной.
+    template <class U>
+    struct SlabAllocator {
+        using value_type = U;
+
+        FigureArena* arena;
+
+        explicit SlabAllocator(FigureArena* arena) : arena(arena) {}
+
+        template <class V>
+        SlabAllocator(const SlabAllocator<V>& other) : arena(other.arena) {}
+
+        U* allocate(size_t n) {
+            return static_cast<U*>(arena->allocate(n * sizeof(U), alignof(U)));
+        }
+
+        void deallocate(U*, size_t) {}
+
+        template <class V>
+        bool operator==(const SlabAllocator<V>& other) const {
+            return arena == other.arena;
+        }
+    };
+
+    struct Release {
+        FigureArena* arena;
+
+        void operator()(Figure<T>*) const {
+            arena->liveFigures_.fetch_sub(1, memory_order_release);
+        }
+    };
+
+    vector<Slab> slabs_;
+    byte* cursor_ = nullptr;
+    byte* limit_ = nullptr;
+    size_t slabSize_;
+    size_t bytesUsed_ = 0;
+    size_t figureCount_ = 0;
+    DestroyRecord* destroyList_ = nullptr;
+    atomic<size_t> liveFigures_{0};
+
+    void addSlab(size_t minBytes) {
+        const size_t size = max(slabSize_, minBytes);
+        slabs_.push_back({unique_ptr<byte[]>(new byte[size]), size});
+        cursor_ = slabs_.back().data.get();
+        limit_ = cursor_ + size;
+    }
+
+    void runDestructors() {
+        for (DestroyRecord* r = destroyList_; r; r = r->next)
+            r->destroy(r->object);
+        destroyList_ = nullptr;
+    }
+
+public:
+    explicit FigureArena(size_t slabSize = 1 << 20)
+        : slabSize_(max<size_t>(slabSize, 256)) {}
+
+    ~FigureArena() {
+        if (getLiveCount() != 0)
+            terminate();
+        runDestructors();
+    }
+
+    FigureArena(const FigureArena&) = delete;
+    FigureArena& operator=(const FigureArena&) = delete;
+
+    void* allocate(size_t bytes, size_t align = alignof(max_align_t)) {
+        size_t space = static_cast<size_t>(limit_ - cursor_);
+        void* p = cursor_;
+        if (!cursor_ || !std::align(align, bytes, p, space)) {
+            addSlab(bytes + align);
+            p = cursor_;
+            space = static_cast<size_t>(limit_ - cursor_);
+            std::align(align, bytes, p, space);
+        }
+        cursor_ = static_cast<byte*>(p) + bytes;
+        bytesUsed_ += bytes;
+        return p;
+    }
+
+    template <class Shape, class... Args>
+    Shape* create(Args&&... args) {
+        static_assert(is_base_of_v<Figure<T>, Shape>, "Shape must derive from Figure<T>");
+        void* memory = allocate(sizeof(Shape), alignof(Shape));
+        Shape* shape = new (memory) Shape(forward<Args>(args)...);
+        if constexpr (!requires { Shape::arity; }) {
+            auto* record = static_cast<DestroyRecord*>(allocate(sizeof(DestroyRecord), alignof(DestroyRecord)));
+            record->next = destroyList_;
+            record->destroy = [](void* object) { static_cast<Shape*>(object)->~Shape(); };
+            record->object = shape;
+            destroyList_ = record;
+        }
+        ++figureCount_;
+        return shape;
+    }
+
+    template <class Shape, class... Args>
+    shared_ptr<Figure<T>> make(Args&&... args) {
+        Shape* shape = create<Shape>(forward<Args>(args)...);
+        shared_ptr<Figure<T>> figure(shape, Release{this}, SlabAllocator<Figure<T>>(this));
+        liveFigures_.fetch_add(1, memory_order_relaxed);
+        return figure;
+    }
+
+    // Уничтожает все фигуры и возвращает память; первый блок остаётся для повторного использования.
+    // Бросает runtime_error, если на фигуры из make() ещё есть shared_ptr.
+    void release() {
+        if (getLiveCount() != 0)
+            throw runtime_error("Фигуры арены ещё используются");
+        runDestructors();
+        if (slabs_.size() > 1)
+            slabs_.erase(slabs_.begin() + 1, slabs_.end());
+        if (!slabs_.empty()) {
+            cursor_ = slabs_.front().data.get();
+            limit_ = cursor_ + slabs_.front().size;
+        }
+        bytesUsed_ = 0;
+        figureCount_ = 0;
+    }
+
+    size_t getFigureCount() const { return figureCount_; }
+    size_t getLiveCount() const { return liveFigures_.load(memory_order_acquire); }
+    size_t getBytesUsed() const { return bytesUsed_; }
+    size_t getSlabCount() const { return slabs_.size(); }
+};
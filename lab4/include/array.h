@@ -1,42 +1,161 @@
 #pragma once
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
 #include <memory>
+#include <ranges>
+#include <stdexcept>
 #include <utility>
+#include <vector>
 #include "figure.h"
+#include "figure_format.h"
+#include "instrumentation.h"
+#include "thread_pool.h"
 
 
 using namespace std;
 
+enum class RemovalPolicy {
+    Ordered,
+    Unordered,
+    Tombstone
+};
+
+enum class CopyMode {
+    Deep,
+    CopyOnWrite
+};
+
+// Новая вместимость при нехватке места: геометрический рост в factor раз
+// или, если chunk > 0, рост порциями по chunk ячеек.
+struct GrowthPolicy {
+    double factor = 2.0;
+    size_t chunk = 0;
+
+    static GrowthPolicy geometric(double factor = 2.0) {
+        return {factor, 0};
+    }
+
+    static GrowthPolicy chunked(size_t chunk) {
+        return {1.0, max<size_t>(chunk, 1)};
+    }
+
+    size_t grow(size_t capacity, size_t required) const {
+        if (chunk > 0)
+            return max(capacity + chunk, (required + chunk - 1) / chunk * chunk);
+        const size_t scaled = static_cast<size_t>(static_cast<double>(capacity) * factor);
+        return max({capacity + 1, scaled, required});
+    }
+};
+
 template <Scalar T>
 class Array {
 private:
+    struct Storage {
+        unique_ptr<shared_ptr<Figure<T>>[]> slots;
+        // Буфер разделялся копией CopyOnWrite: его фигуры могут быть общими с ней.
+        atomic<bool> copied{false};
+
+        explicit Storage(size_t capacity) : slots(new shared_ptr<Figure<T>>[capacity]) {}
+    };
+
+    shared_ptr<Storage> storage_;
     shared_ptr<Figure<T>>* figures_; 
     size_t size_;
     size_t capacity_;
+    size_t tombstones_ = 0;
+    CopyMode copyMode_ = CopyMode::Deep;
+    GrowthPolicy growth_;
+    // Пусто, если ни одна ячейка не может быть общей; иначе по флагу на ячейку.
+    // Байты, а не биты: parallel transform снимает флаги разных ячеек одновременно.
+    vector<uint8_t> mayBeShared_;
+
+    static shared_ptr<Storage> allocate(size_t capacity) {
+        LAB4_COUNT(Allocations, 1);
+        return make_shared<Storage>(capacity);
+    }
+
+    bool copied() const {
+        return storage_ && storage_->copied.load(memory_order_acquire);
+    }
+
+    void markAllShared() {
+        mayBeShared_.assign(size_, 1);
+    }
+
+    void markShared(size_t index, bool shared) {
+        if (mayBeShared_.empty()) {
+            if (!shared) return;
+            mayBeShared_.assign(size_, 0);
+        }
+        mayBeShared_[index] = shared;
+    }
 
     void resize(size_t new_capacity) {
-        auto* new_data = new shared_ptr<Figure<T>>[new_capacity];
+        LAB4_COUNT(Resizes, 1);
+        LAB4_TIME(Resize);
+        auto new_storage = allocate(new_capacity);
+        const bool shared = copied();
         for (size_t i = 0; i < size_; ++i)
-            new_data[i] = move(figures_[i]);
-        delete[] figures_;
-        figures_ = new_data;
+            new_storage->slots[i] = shared ? figures_[i] : move(figures_[i]);
+        if (shared)
+            markAllShared();
+        storage_ = move(new_storage);
+        figures_ = storage_->slots.get();
         capacity_ = new_capacity;
     }
 
+    // Перед записью: буфер, который разделялся копией, заменяется своим (если копия ещё
+    // держит его), а все ячейки помечаются как возможно общие — фигуры остаются общими.
+    void detach() {
+        if (!copied()) return;
+        if (storage_.use_count() > 1) {
+            resize(capacity_);
+        } else {
+            markAllShared();
+            storage_->copied.store(false, memory_order_relaxed);
+        }
+    }
+
+    // После detach(): клонирует фигуру помеченной ячейки, если ею владеет не только Array.
+    Figure<T>* unshare(size_t index) {
+        auto& slot = figures_[index];
+        if (!mayBeShared_.empty() && mayBeShared_[index]) {
+            if (slot && slot.use_count() != 1)
+                slot = shared_ptr<Figure<T>>(slot->clone().release());
+            mayBeShared_[index] = 0;
+        }
+        return slot.get();
+    }
+
 public:
     Array(size_t capacity = 2)
-        : figures_(new shared_ptr<Figure<T>>[capacity]),
+        : storage_(allocate(capacity)),
+          figures_(storage_->slots.get()),
           size_(0),
           capacity_(capacity) {}
 
-    ~Array() {
-        delete[] figures_;
-    }
+    ~Array() = default;
 
+    // В режиме CopyOnWrite копия разделяет буфер и фигуры с оригиналом до первой записи.
+    // Оригинал не изменяется: отметка о копировании ставится атомарно в общем буфере,
+    // поэтому копировать один const Array можно из нескольких потоков.
     Array(const Array& other)
-        : figures_(new shared_ptr<Figure<T>>[other.capacity_]),
-          size_(other.size_),
-          capacity_(other.capacity_) {
+        : size_(other.size_),
+          capacity_(other.capacity_),
+          tombstones_(other.tombstones_),
+          copyMode_(other.copyMode_),
+          growth_(other.growth_) {
+        if (copyMode_ == CopyMode::CopyOnWrite) {
+            storage_ = other.storage_;
+            figures_ = other.figures_;
+            storage_->copied.store(true, memory_order_release);
+            return;
+        }
+        storage_ = allocate(capacity_);
+        figures_ = storage_->slots.get();
         for (size_t i = 0; i < size_; ++i) {
             if (other.figures_[i])
                 figures_[i] = shared_ptr<Figure<T>>(other.figures_[i]->clone().release());
@@ -46,32 +165,223 @@ public:
     }
 
     Array(Array&& other) noexcept
-        : figures_(other.figures_),
+        : storage_(move(other.storage_)),
+          figures_(other.figures_),
           size_(other.size_),
-          capacity_(other.capacity_) {
+          capacity_(other.capacity_),
+          tombstones_(other.tombstones_),
+          copyMode_(other.copyMode_),
+          growth_(other.growth_),
+          mayBeShared_(move(other.mayBeShared_)) {
         other.figures_ = nullptr;
         other.size_ = 0;
         other.capacity_ = 0;
+        other.tombstones_ = 0;
     }
 
     Array& operator=(Array other) noexcept {
+        swap(storage_, other.storage_);
         swap(figures_, other.figures_);
         swap(size_, other.size_);
         swap(capacity_, other.capacity_);
+        swap(tombstones_, other.tombstones_);
+        swap(copyMode_, other.copyMode_);
+        swap(growth_, other.growth_);
+        swap(mayBeShared_, other.mayBeShared_);
         return *this;
     }
 
+    void setCopyMode(CopyMode mode) { copyMode_ = mode; }
+    CopyMode getCopyMode() const { return copyMode_; }
+    bool sharesStorage() const { return storage_.use_count() > 1; }
+
+    void setGrowthPolicy(const GrowthPolicy& policy) { growth_ = policy; }
+    const GrowthPolicy& getGrowthPolicy() const { return growth_; }
+
+    // Вместимость не меньше capacity; лишнего не выделяет.
+    void reserve(size_t capacity) {
+        if (capacity > capacity_)
+            resize(capacity);
+    }
+
+    // Освобождает запас сверх текущего размера (минимум одна ячейка).
+    void shrinkToFit() {
+        const size_t target = max<size_t>(size_, 1);
+        if (target < capacity_)
+            resize(target);
+    }
+
     void addFigure(const shared_ptr<Figure<T>>& figure) {
         if (size_ >= capacity_)
-            resize(capacity_ * 2);
+            resize(growth_.grow(capacity_, size_ + 1));
+        else
+            detach();
+        if (!mayBeShared_.empty())
+            mayBeShared_.push_back(0);
         figures_[size_++] = figure;
     }
 
+    void addFigure(shared_ptr<Figure<T>>&& figure) {
+        if (size_ >= capacity_)
+            resize(growth_.grow(capacity_, size_ + 1));
+        else
+            detach();
+        if (!mayBeShared_.empty())
+            mayBeShared_.push_back(0);
+        figures_[size_++] = move(figure);
+    }
+
+    // Пустая ячейка, учтённая как удалённая (Tombstone): compact() её уберёт.
+    void addTombstone() {
+        addFigure(nullptr);
+        ++tombstones_;
+    }
+
+    // Фигура из unique_ptr переходит в Array без копирования.
+    template <typename Shape>
+        requires derived_from<Shape, Figure<T>>
+    void addFigure(unique_ptr<Shape>&& figure) {
+        addFigure(shared_ptr<Figure<T>>(move(figure)));
+    }
+
+    // Создаёт фигуру на месте: объект и счётчик ссылок — одно выделение, без лишних инкрементов.
+    template <typename Shape, typename... Args>
+        requires derived_from<Shape, Figure<T>>
+    Shape& emplaceFigure(Args&&... args) {
+        auto figure = make_shared<Shape>(forward<Args>(args)...);
+        Shape& result = *figure;
+        addFigure(shared_ptr<Figure<T>>(move(figure)));
+        return result;
+    }
+
+    // Добавляет все фигуры диапазона; если его длина известна заранее, память растёт не больше одного раза.
+    // Из rvalue-диапазона указатели переносятся, а не копируются.
+    template <typename Range>
+    void addFigures(Range&& figures) {
+        if constexpr (ranges::forward_range<const remove_reference_t<Range>>) {
+            const size_t required = size_ + static_cast<size_t>(ranges::distance(figures));
+            if (required > capacity_)
+                resize(growth_.grow(capacity_, required));
+        }
+        for (auto&& figure : figures) {
+            if constexpr (is_lvalue_reference_v<Range>)
+                addFigure(figure);
+            else
+                addFigure(move(figure));
+        }
+    }
+
     void removeFigure(size_t index) {
         if (index >= size_) return;
+        detach();
+        if (!figures_[index] && tombstones_ > 0) --tombstones_;
         for (size_t i = index; i < size_ - 1; ++i)
             figures_[i] = move(figures_[i + 1]);
-        --size_;
+        if (!mayBeShared_.empty())
+            mayBeShared_.erase(mayBeShared_.begin() + static_cast<ptrdiff_t>(index));
+        figures_[--size_].reset();
+    }
+
+    // Unordered: последний элемент переносится на место удалённого, O(1).
+    // Tombstone: ячейка только очищается, индексы остальных не меняются до compact().
+    void removeFigure(size_t index, RemovalPolicy policy) {
+        if (index >= size_) return;
+        detach();
+        switch (policy) {
+            case RemovalPolicy::Ordered:
+                removeFigure(index);
+                break;
+            case RemovalPolicy::Unordered:
+                if (!figures_[index] && tombstones_ > 0) --tombstones_;
+                if (index != size_ - 1)
+                    figures_[index] = move(figures_[size_ - 1]);
+                if (!mayBeShared_.empty()) {
+                    mayBeShared_[index] = mayBeShared_[size_ - 1];
+                    mayBeShared_.pop_back();
+                }
+                figures_[--size_].reset();
+                break;
+            case RemovalPolicy::Tombstone:
+                if (figures_[index]) {
+                    figures_[index].reset();
+                    ++tombstones_;
+                }
+                break;
+        }
+    }
+
+    // Удаляет все пустые ячейки за один проход, сохраняя порядок.
+    size_t compact() {
+        detach();
+        size_t out = 0;
+        for (size_t i = 0; i < size_; ++i) {
+            if (!figures_[i]) continue;
+            if (!mayBeShared_.empty())
+                mayBeShared_[out] = mayBeShared_[i];
+            figures_[out++] = move(figures_[i]);
+        }
+        if (!mayBeShared_.empty())
+            mayBeShared_.resize(out);
+        const size_t removed = size_ - out;
+        for (size_t i = out; i < size_; ++i)
+            figures_[i].reset();
+        size_ = out;
+        tombstones_ = 0;
+        return removed;
+    }
+
+    template <typename Predicate>
+    size_t removeIf(Predicate pred) {
+        detach();
+        size_t out = 0;
+        for (size_t i = 0; i < size_; ++i) {
+            if (figures_[i] && pred(*figures_[i]))
+                continue;
+            if (out != i) {
+                figures_[out] = move(figures_[i]);
+                if (!mayBeShared_.empty())
+                    mayBeShared_[out] = mayBeShared_[i];
+            }
+            ++out;
+        }
+        if (!mayBeShared_.empty())
+            mayBeShared_.resize(out);
+        const size_t removed = size_ - out;
+        for (size_t i = out; i < size_; ++i)
+            figures_[i].reset();
+        size_ = out;
+        return removed;
+    }
+
+    size_t getTombstoneCount() const { return tombstones_; }
+
+    // Переставляет ячейки на месте: i-й становится ячейка order[i], не вошедшие в order
+    // идут следом в прежнем порядке. Фигуры не копируются; вместимость, политика роста
+    // и счётчик удалённых ячеек сохраняются.
+    void permute(const vector<size_t>& order) {
+        vector<char> used(size_, 0);
+        for (size_t index : order) {
+            if (index >= size_ || used[index])
+                throw runtime_error("Неверная перестановка ячеек");
+            used[index] = 1;
+        }
+        detach();
+        vector<shared_ptr<Figure<T>>> slots;
+        vector<uint8_t> shared;
+        slots.reserve(size_);
+        auto take = [&](size_t index) {
+            slots.push_back(move(figures_[index]));
+            if (!mayBeShared_.empty())
+                shared.push_back(mayBeShared_[index]);
+        };
+        for (size_t index : order)
+            take(index);
+        for (size_t i = 0; i < size_; ++i)
+            if (!used[i])
+                take(i);
+        move(slots.begin(), slots.end(), figures_);
+        if (!mayBeShared_.empty())
+            mayBeShared_ = move(shared);
     }
 
     shared_ptr<Figure<T>> getFigure(size_t index) const {
@@ -79,6 +389,46 @@ public:
         return figures_[index];
     }
 
+    // Заменяет фигуру в ячейке. Если фигура уже используется где-то ещё,
+    // mutableFigure перед изменением склонирует её, а не изменит общую.
+    void setFigure(size_t index, const shared_ptr<Figure<T>>& figure) {
+        if (index >= size_) return;
+        detach();
+        if (!figures_[index] && figure && tombstones_ > 0) --tombstones_;
+        else if (figures_[index] && !figure) ++tombstones_;
+        figures_[index] = figure;
+        markShared(index, figure != nullptr);
+    }
+
+    // Доступ для изменения фигуры: если она может быть общей с копией, сначала клонируется.
+    shared_ptr<Figure<T>> mutableFigure(size_t index) {
+        if (index >= size_) return nullptr;
+        detach();
+        unshare(index);
+        return figures_[index];
+    }
+
+    // Аффинное преобразование всех фигур на месте, без выделения памяти
+    // (кроме клонирования фигур, общих с копией в режиме CopyOnWrite).
+    void transform(const Affine2D& m) {
+        detach();
+        for (size_t i = 0; i < size_; ++i)
+            if (Figure<T>* figure = unshare(i))
+                figure->transform(m);
+    }
+
+    void transform(const Affine2D& m, ThreadPool& pool, size_t grain = 4096) {
+        detach();
+        pool.parallelFor(size_, grain, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                if (Figure<T>* figure = unshare(i))
+                    figure->transform(m);
+        });
+    }
+
+    const shared_ptr<Figure<T>>* begin() const { return figures_; }
+    const shared_ptr<Figure<T>>* end() const { return figures_ + size_; }
+
     size_t getSize() const { return size_; }
     size_t getCapacity() const { return capacity_; }
 
@@ -91,18 +441,11 @@ public:
     }
 
     void printFigures() const {
-        for (size_t i = 0; i < size_; ++i) {
-            cout << "Фигура " << i << ": ";
-            if (figures_[i]) {
-                figures_[i]->print(cout);
-                auto center = figures_[i]->getCenter();
-                cout << " | Центр: " << center
-                          << " | Площадь: " << static_cast<double>(*figures_[i]);
-            } else {
-                cout << "(пусто)";
-            }
-            cout << '\n';
-        }
+        printFigures(cout);
+    }
+
+    void printFigures(ostream& os) const {
+        writeFigures(os, *this);
     }
 
     shared_ptr<Figure<T>> operator[](size_t index) const {
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <utility>
+
+#include "figure.h"
+#include "instrumentation.h"
+
+using namespace std;
+
+// Фигура Shape<T> с кешем: площадь, центр и ограничивающий прямоугольник вычисляются
+// при первом запросе и хранятся, пока вершины не изменятся (setPoint, setPoints, read,
+// присваивание). Сами фигуры кеша не несут и остаются компактными; обёртка нужна там,
+// где одни и те же фигуры опрашиваются многократно.
+// Константные методы можно вызывать из нескольких потоков: значение записывает только поток,
+// первым занявший бит BUSY, и публикует его битом CACHED (release); читатели проверяют бит с acquire.
+// Изменять вершины одновременно с чтением нельзя.
+template <Scalar T, template <Scalar> class Shape>
+class CachedFigure final : public Figure<T> {
+private:
+    enum : uint8_t {
+        AREA_CACHED = 1,
+        CENTER_CACHED = 2,
+        BOX_CACHED = 4,
+        ALL_CACHED = AREA_CACHED | CENTER_CACHED | BOX_CACHED,
+        // Значение уже вычисляет и записывает другой поток.
+        AREA_BUSY = 8,
+        CENTER_BUSY = 16,
+        BOX_BUSY = 32
+    };
+
+    Shape<T> shape_;
+    mutable double area_ = 0.0;
+    mutable Point<T> center_{};
+    mutable BoundingBox<T> box_{};
+    mutable atomic<uint8_t> cached_{0};
+
+    void copyCache(const CachedFigure& other) {
+        const uint8_t state = other.cached_.load(memory_order_acquire) & ALL_CACHED;
+        if (state & AREA_CACHED)
+            area_ = other.area_;
+        if (state & CENTER_CACHED)
+            center_ = other.center_;
+        if (state & BOX_CACHED)
+            box_ = other.box_;
+        cached_.store(state, memory_order_relaxed);
+    }
+
+    // Возвращает вычисленное значение; в кеш его записывает только поток, занявший busy.
+    template <typename V, typename Compute>
+    V cachedValue(V& slot, uint8_t ready, uint8_t busy, Compute compute) const {
+        if (cached_.load(memory_order_acquire) & ready)
+            return slot;
+        const V value = compute();
+        if (!(cached_.fetch_or(busy, memory_order_acquire) & busy)) {
+            slot = value;
+            cached_.fetch_or(ready, memory_order_release);
+        }
+        return value;
+    }
+
+    void invalidate() {
+        cached_.store(0, memory_order_relaxed);
+    }
+
+public:
+    static constexpr size_t arity = Shape<T>::arity;
+
+    template <typename... Args>
+        requires constructible_from<Shape<T>, Args...>
+    explicit CachedFigure(Args&&... args) : shape_(forward<Args>(args)...) {}
+
+    CachedFigure(const CachedFigure& other) : Figure<T>(other), shape_(other.shape_) {
+        copyCache(other);
+    }
+
+    CachedFigure& operator=(const CachedFigure& other) {
+        shape_ = other.shape_;
+        copyCache(other);
+        return *this;
+    }
+
+    const Shape<T>& shape() const {
+        return shape_;
+    }
+
+    // Промах считает сама фигура (AreaCalls и AreaComputations), попадание — только AreaCalls.
+    double getArea() const override {
+        if (cached_.load(memory_order_acquire) & AREA_CACHED) {
+            LAB4_COUNT(AreaCalls, 1);
+            return area_;
+        }
+        return cachedValue(area_, AREA_CACHED, AREA_BUSY, [this] { return shape_.getArea(); });
+    }
+
+    Point<T> getCenter() const override {
+        return cachedValue(center_, CENTER_CACHED, CENTER_BUSY, [this] { return shape_.getCenter(); });
+    }
+
+    BoundingBox<T> getBoundingBox() const override {
+        return cachedValue(box_, BOX_CACHED, BOX_BUSY, [this] { return shape_.getBoundingBox(); });
+    }
+
+    operator double() const override {
+        return getArea();
+    }
+
+    void print(ostream& os) const override {
+        shape_.print(os);
+    }
+
+    void read(istream& is) override {
+        invalidate();
+        shape_.read(is);
+    }
+
+    // Равна и обёртке над такой же фигурой, и самой фигуре.
+    bool operator==(const Figure<T>& other) const override {
+        if (const auto* cached = dynamic_cast<const CachedFigure*>(&other))
+            return shape_ == cached->shape_;
+        return shape_ == other;
+    }
+
+    unique_ptr<Figure<T>> clone() const override {
+        LAB4_COUNT(Clones, 1);
+        LAB4_TIME(Clone);
+        return make_unique<CachedFigure>(*this);
+    }
+
+    FigureKind kind() const override {
+        return shape_.kind();
+    }
+
+    size_t getSize() const override {
+        return arity;
+    }
+
+    const Point<T>* getPoints() const override {
+        return shape_.getPoints();
+    }
+
+    const Point<T>& getPoint(size_t index) const {
+        return shape_.getPoint(index);
+    }
+
+    void setPoint(size_t index, const Point<T>& point) {
+        shape_.setPoint(index, point);
+        invalidate();
+    }
+
+    void setPoints(const array<Point<T>, arity>& points) {
+        shape_.setPoints(points);
+        invalidate();
+    }
+
+    // Вершины преобразуются на месте. Для вещественных T кеш не пересчитывается, а обновляется:
+    // площадь умножается на |det|, центр переносится тем же преобразованием, прямоугольник —
+    // если оси переходят в оси. Для целых T вершины округляются, поэтому кеш сохраняется
+    // только при сдвиге на целые (площадь не меняется).
+    void transform(const Affine2D& m) override {
+        shape_.transform(m);
+        const uint8_t state = cached_.load(memory_order_relaxed) & ALL_CACHED;
+        if constexpr (ScalarTraits<T>::exact) {
+            const bool integerShift = m.isTranslation() && m.tx == rint(m.tx) && m.ty == rint(m.ty);
+            cached_.store(integerShift ? state & AREA_CACHED : 0, memory_order_relaxed);
+        } else {
+            uint8_t keep = 0;
+            if ((state & AREA_CACHED) && (shape_.areaScalesWithDeterminant() || m.isSimilarity())) {
+                area_ *= abs(m.det());
+                keep |= AREA_CACHED;
+            }
+            if (state & CENTER_CACHED) {
+                center_ = m.apply(center_);
+                keep |= CENTER_CACHED;
+            }
+            if ((state & BOX_CACHED) && m.isAxisAligned()) {
+                const Point<T> lo = m.apply(box_.lo), hi = m.apply(box_.hi);
+                box_ = {Point<T>(min(lo.x, hi.x), min(lo.y, hi.y)), Point<T>(max(lo.x, hi.x), max(lo.y, hi.y))};
+                keep |= BOX_CACHED;
+            }
+            cached_.store(keep, memory_order_relaxed);
+        }
+    }
+};
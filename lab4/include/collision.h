@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "array.h"
+#include "figure.h"
+#include "point.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace collision_detail {
+
+// true, если проекции на нормаль одного из рёбер a не пересекаются.
+template <Scalar T>
+bool separatedByEdgesOf(const Point<T>* a, size_t na, const Point<T>* b, size_t nb) {
+    for (size_t i = 0; i < na; ++i) {
+        const auto& p = a[i];
+        const auto& q = a[i + 1 == na ? 0 : i + 1];
+        const double nx = static_cast<double>(p.y) - static_cast<double>(q.y);
+        const double ny = static_cast<double>(q.x) - static_cast<double>(p.x);
+        if (nx == 0.0 && ny == 0.0) continue;
+
+        double minA = INFINITY, maxA = -INFINITY, minB = INFINITY, maxB = -INFINITY;
+        for (size_t k = 0; k < na; ++k) {
+            const double d = nx * static_cast<double>(a[k].x) + ny * static_cast<double>(a[k].y);
+            minA = min(minA, d);
+            maxA = max(maxA, d);
+        }
+        for (size_t k = 0; k < nb; ++k) {
+            const double d = nx * static_cast<double>(b[k].x) + ny * static_cast<double>(b[k].y);
+            minB = min(minB, d);
+            maxB = max(maxB, d);
+        }
+        if (maxA < minB || maxB < minA) return true;
+    }
+    return false;
+}
+
+}
+
+// Теорема о разделяющей оси: многоугольники считаются выпуклыми, касание — пересечением.
+// Для невыпуклого пятиугольника результат относится к его выпуклой оболочке только
+// частично, поэтому такие фигуры стоит отсеять BatchValidator (NOT_CONVEX).
+template <Scalar T>
+bool convexPolygonsIntersect(const Point<T>* a, size_t na, const Point<T>* b, size_t nb) {
+    return !collision_detail::separatedByEdgesOf(a, na, b, nb) &&
+           !collision_detail::separatedByEdgesOf(b, nb, a, na);
+}
+
+template <Scalar T>
+bool figuresIntersect(const Figure<T>& a, const Figure<T>& b) {
+    return a.getBoundingBox().intersects(b.getBoundingBox()) &&
+           convexPolygonsIntersect(a.getPoints(), a.getSize(), b.getPoints(), b.getSize());
+}
+
+// Все пары пересекающихся фигур: широкая фаза — sort-and-sweep по ограничивающим
+// прямоугольникам вдоль оси с большим разбросом центров, узкая — SAT.
+// Время O(n log n + m), где m — число пар, чьи проекции на ось развёртки пересекаются.
+template <Scalar T>
+class CollisionDetector {
+private:
+    struct Entry {
+        double lo;
+        double hi;
+        double otherLo;
+        double otherHi;
+        size_t index;
+    };
+
+    ThreadPool& pool_;
+    size_t grain_;
+
+public:
+    explicit CollisionDetector(ThreadPool& pool = ThreadPool::instance(), size_t grain = 1024)
+        : pool_(pool), grain_(max<size_t>(grain, 1)) {}
+
+    // Пары индексов Array (first < second) в лексикографическом порядке; пустые ячейки пропускаются.
+    vector<pair<size_t, size_t>> findPairs(const Array<T>& array) const {
+        vector<const Figure<T>*> figures(array.getSize());
+        vector<BoundingBox<T>> boxes(array.getSize());
+        double sumX = 0.0, sumY = 0.0, sumX2 = 0.0, sumY2 = 0.0;
+        size_t count = 0;
+        for (size_t i = 0; i < array.getSize(); ++i) {
+            figures[i] = array[i].get();
+            if (!figures[i]) continue;
+            boxes[i] = figures[i]->getBoundingBox();
+            const double cx = (static_cast<double>(boxes[i].lo.x) + static_cast<double>(boxes[i].hi.x)) / 2.0;
+            const double cy = (static_cast<double>(boxes[i].lo.y) + static_cast<double>(boxes[i].hi.y)) / 2.0;
+            sumX += cx;
+            sumY += cy;
+            sumX2 += cx * cx;
+            sumY2 += cy * cy;
+            ++count;
+        }
+        if (count < 2) return {};
+
+        // Развёртка вдоль оси с большей дисперсией центров даёт меньше ложных кандидатов.
+        const bool alongX = sumX2 - sumX * sumX / count >= sumY2 - sumY * sumY / count;
+        vector<Entry> entries;
+        entries.reserve(count);
+        for (size_t i = 0; i < figures.size(); ++i) {
+            if (!figures[i]) continue;
+            const auto& b = boxes[i];
+            const double lx = static_cast<double>(b.lo.x), hx = static_cast<double>(b.hi.x);
+            const double ly = static_cast<double>(b.lo.y), hy = static_cast<double>(b.hi.y);
+            entries.push_back(alongX ? Entry{lx, hx, ly, hy, i} : Entry{ly, hy, lx, hx, i});
+        }
+        sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+            return a.lo < b.lo || (a.lo == b.lo && a.index < b.index);
+        });
+
+        const size_t chunks = (entries.size() + grain_ - 1) / grain_;
+        vector<vector<pair<size_t, size_t>>> found(chunks);
+        pool_.parallelFor(entries.size(), grain_, [&](size_t begin, size_t end) {
+            auto& out = found[begin / grain_];
+            for (size_t i = begin; i < end; ++i) {
+                const Entry& e = entries[i];
+                for (size_t j = i + 1; j < entries.size() && entries[j].lo <= e.hi; ++j) {
+                    const Entry& o = entries[j];
+                    if (o.otherLo > e.otherHi || e.otherLo > o.otherHi) continue;
+                    const Figure<T>& a = *figures[e.index];
+                    const Figure<T>& b = *figures[o.index];
+                    if (convexPolygonsIntersect(a.getPoints(), a.getSize(), b.getPoints(), b.getSize()))
+                        out.emplace_back(min(e.index, o.index), max(e.index, o.index));
+                }
+            }
+        });
+
+        vector<pair<size_t, size_t>> pairs;
+        size_t total = 0;
+        for (const auto& part : found)
+            total += part.size();
+        pairs.reserve(total);
+        for (const auto& part : found)
+            pairs.insert(pairs.end(), part.begin(), part.end());
+        sort(pairs.begin(), pairs.end());
+        return pairs;
+    }
+};
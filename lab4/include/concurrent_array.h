@@ -0,0 +1,270 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "array.h"
+#include "figure.h"
+
+using namespace std;
+
+// Эпохи для отложенного освобождения: читатель объявляет текущую эпоху на время доступа,
+// удалённый элемент освобождается, когда эпоха сдвинулась на два шага после удаления.
+// Если все MAX_READERS слотов заняты, читатель не ждёт, а учитывается общим счётчиком
+// overflow_, который запрещает сдвигать эпоху, пока такие читатели активны.
+class EpochManager {
+private:
+    static constexpr size_t MAX_READERS = 256;
+
+    atomic<uint64_t> epoch_{1};
+    atomic<uint64_t> announce_[MAX_READERS] = {};
+    atomic<size_t> overflow_{0};
+
+public:
+    class Guard {
+    private:
+        EpochManager* manager_;
+        size_t slot_ = MAX_READERS;
+
+    public:
+        explicit Guard(EpochManager& manager) : manager_(&manager) {
+            const size_t start = hash<thread::id>()(this_thread::get_id()) % MAX_READERS;
+            for (size_t k = 0; k < MAX_READERS; ++k) {
+                const size_t i = (start + k) % MAX_READERS;
+                uint64_t expected = 0;
+                uint64_t e = manager.epoch_.load(memory_order_acquire);
+                if (manager.announce_[i].compare_exchange_strong(expected, e, memory_order_seq_cst)) {
+                    slot_ = i;
+                    break;
+                }
+            }
+            if (slot_ == MAX_READERS) {
+                manager.overflow_.fetch_add(1, memory_order_seq_cst);
+                return;
+            }
+            // Эпоха могла сдвинуться между чтением и объявлением — обновляем объявление.
+            while (true) {
+                uint64_t e = manager.epoch_.load(memory_order_seq_cst);
+                manager.announce_[slot_].store(e, memory_order_seq_cst);
+                if (manager.epoch_.load(memory_order_seq_cst) == e) break;
+            }
+        }
+
+        ~Guard() {
+            if (slot_ == MAX_READERS)
+                manager_->overflow_.fetch_sub(1, memory_order_release);
+            else
+                manager_->announce_[slot_].store(0, memory_order_release);
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    uint64_t current() const {
+        return epoch_.load(memory_order_acquire);
+    }
+
+    // Сдвигает эпоху, если все активные читатели уже в текущей и ни один не остался без слота.
+    uint64_t tryAdvance() {
+        uint64_t e = epoch_.load(memory_order_seq_cst);
+        if (overflow_.load(memory_order_seq_cst) != 0)
+            return e;
+        for (const auto& a : announce_) {
+            uint64_t seen = a.load(memory_order_seq_cst);
+            if (seen != 0 && seen != e)
+                return e;
+        }
+        epoch_.compare_exchange_strong(e, e + 1, memory_order_seq_cst);
+        return epoch_.load(memory_order_seq_cst);
+    }
+};
+
+// Контейнер для параллельной записи и чтения: addFigure и чтение по индексу без блокировок
+// (lock-free), элементы никогда не перемещаются (сегменты растут как 64, 128, 256, ...).
+// Удалённые элементы освобождаются пачками: список отложенных обходится раз в RECLAIM_BATCH удалений.
+// Обходы (forEach, getAllArea, snapshot) не останавливают писателей, поэтому это не
+// мгновенный снимок: каждая фигура видна не больше одного раза, фигуры, добавленные до
+// начала обхода и не удалённые до его конца, видны всегда, а добавляемые или удаляемые
+// во время обхода — в зависимости от того, успел ли обход дойти до их ячейки.
+template <Scalar T>
+class ConcurrentArray {
+private:
+    static constexpr size_t BASE_SHIFT = 6;
+    static constexpr size_t BASE = size_t(1) << BASE_SHIFT;
+    static constexpr size_t MAX_SEGMENTS = 48;
+    static constexpr size_t RECLAIM_BATCH = 64;
+
+    struct Node {
+        shared_ptr<Figure<T>> figure;
+    };
+
+    struct Retired {
+        Node* node;
+        uint64_t epoch;
+        Retired* next;
+    };
+
+    using Slot = atomic<Node*>;
+
+    atomic<Slot*> segments_[MAX_SEGMENTS] = {};
+    atomic<size_t> reserved_{0};
+    atomic<Retired*> retired_{nullptr};
+    atomic<size_t> removedSinceReclaim_{0};
+    mutable EpochManager epochs_;
+
+    static size_t segmentOf(size_t index) {
+        return static_cast<size_t>(bit_width((index >> BASE_SHIFT) + 1)) - 1;
+    }
+
+    static size_t segmentStart(size_t segment) {
+        return ((size_t(1) << segment) - 1) << BASE_SHIFT;
+    }
+
+    static size_t segmentSize(size_t segment) {
+        return BASE << segment;
+    }
+
+    Slot* segment(size_t s) {
+        Slot* seg = segments_[s].load(memory_order_acquire);
+        if (seg) return seg;
+        Slot* fresh = new Slot[segmentSize(s)];
+        for (size_t i = 0; i < segmentSize(s); ++i)
+            fresh[i].store(nullptr, memory_order_relaxed);
+        if (segments_[s].compare_exchange_strong(seg, fresh, memory_order_acq_rel))
+            return fresh;
+        delete[] fresh;
+        return seg;
+    }
+
+    Slot* slot(size_t index) const {
+        const size_t s = segmentOf(index);
+        Slot* seg = segments_[s].load(memory_order_acquire);
+        return seg ? seg + (index - segmentStart(s)) : nullptr;
+    }
+
+    void pushRetired(Retired* first, Retired* last) {
+        Retired* head = retired_.load(memory_order_relaxed);
+        do {
+            last->next = head;
+        } while (!retired_.compare_exchange_weak(head, first, memory_order_release, memory_order_relaxed));
+    }
+
+    void reclaim() {
+        const uint64_t epoch = epochs_.tryAdvance();
+        Retired* list = retired_.exchange(nullptr, memory_order_acquire);
+        Retired* keepFirst = nullptr;
+        Retired* keepLast = nullptr;
+        while (list) {
+            Retired* next = list->next;
+            if (list->epoch + 2 <= epoch) {
+                delete list->node;
+                delete list;
+            } else {
+                list->next = keepFirst;
+                keepFirst = list;
+                if (!keepLast) keepLast = list;
+            }
+            list = next;
+        }
+        if (keepFirst)
+            pushRetired(keepFirst, keepLast);
+    }
+
+public:
+    ConcurrentArray() = default;
+
+    ~ConcurrentArray() {
+        for (size_t s = 0; s < MAX_SEGMENTS; ++s) {
+            Slot* seg = segments_[s].load(memory_order_relaxed);
+            if (!seg) continue;
+            for (size_t i = 0; i < segmentSize(s); ++i)
+                delete seg[i].load(memory_order_relaxed);
+            delete[] seg;
+        }
+        for (Retired* r = retired_.load(memory_order_relaxed); r;) {
+            Retired* next = r->next;
+            delete r->node;
+            delete r;
+            r = next;
+        }
+    }
+
+    ConcurrentArray(const ConcurrentArray&) = delete;
+    ConcurrentArray& operator=(const ConcurrentArray&) = delete;
+
+    // Возвращает индекс новой фигуры.
+    size_t addFigure(const shared_ptr<Figure<T>>& figure) {
+        const size_t index = reserved_.fetch_add(1, memory_order_relaxed);
+        const size_t s = segmentOf(index);
+        Slot* seg = segment(s);
+        seg[index - segmentStart(s)].store(new Node{figure}, memory_order_release);
+        return index;
+    }
+
+    // Число занятых индексов, включая ещё не опубликованные и удалённые.
+    size_t getSize() const {
+        return reserved_.load(memory_order_acquire);
+    }
+
+    shared_ptr<Figure<T>> getFigure(size_t index) const {
+        if (index >= getSize()) return nullptr;
+        EpochManager::Guard guard(epochs_);
+        Slot* s = slot(index);
+        Node* node = s ? s->load(memory_order_acquire) : nullptr;
+        return node ? node->figure : nullptr;
+    }
+
+    bool removeFigure(size_t index) {
+        if (index >= getSize()) return false;
+        Slot* s = slot(index);
+        Node* node = s ? s->exchange(nullptr, memory_order_acq_rel) : nullptr;
+        if (!node) return false;
+        auto* r = new Retired{node, epochs_.current(), nullptr};
+        pushRetired(r, r);
+        if (removedSinceReclaim_.fetch_add(1, memory_order_relaxed) + 1 >= RECLAIM_BATCH) {
+            removedSinceReclaim_.store(0, memory_order_relaxed);
+            reclaim();
+        }
+        return true;
+    }
+
+    // Обходит опубликованные фигуры за один проход под защитой эпохи
+    // (гарантии видимости — в описании класса).
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        EpochManager::Guard guard(epochs_);
+        const size_t n = getSize();
+        for (size_t i = 0; i < n; ++i) {
+            Slot* s = slot(i);
+            Node* node = s ? s->load(memory_order_acquire) : nullptr;
+            if (node && node->figure)
+                fn(i, *node->figure);
+        }
+    }
+
+    double getAllArea() const {
+        double total = 0.0;
+        forEach([&total](size_t, const Figure<T>& figure) { total += figure.getArea(); });
+        return total;
+    }
+
+    // Копия текущего содержимого с теми же гарантиями, что у forEach; фигуры общие.
+    Array<T> snapshot() const {
+        Array<T> array;
+        EpochManager::Guard guard(epochs_);
+        const size_t n = getSize();
+        for (size_t i = 0; i < n; ++i) {
+            Slot* s = slot(i);
+            Node* node = s ? s->load(memory_order_acquire) : nullptr;
+            if (node && node->figure)
+                array.addFigure(node->figure);
+        }
+        return array;
+    }
+};
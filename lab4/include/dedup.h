@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "array.h"
+#include "figure.h"
+#include "point.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+// Результат группировки: representative[i] — индекс первой фигуры группы, в которую попала i-я.
+// Пустые ячейки Array представляют сами себя и не считаются дубликатами.
+struct DedupResult {
+    vector<size_t> representative;
+    vector<size_t> unique;
+    size_t duplicates = 0;
+};
+
+// Поиск дубликатов по хешу типа и квантованных координат вершин за ожидаемое линейное время.
+// Равенство то же, что у Figure::operator==: тот же тип и вершины по порядку совпадают
+// с допуском Point::operator== (1e-9 для вещественных, точно для целых).
+// Координаты квантуются ячейками CELL; значение ближе EPS к границе ячейки дополнительно
+// ищется в соседней, поэтому близкие дубликаты по разные стороны границы не теряются.
+// Группировка жадная, как при последовательном проходе: фигура присоединяется к первому
+// по индексу представителю, равному ей, иначе сама становится представителем.
+template <Scalar T>
+class Deduplicator {
+private:
+    static constexpr double EPS = 1e-9;
+    static constexpr double CELL = 1e-6;
+    static constexpr size_t MAX_NEAR = 10;
+
+    ThreadPool& pool_;
+    size_t shards_;
+    size_t grain_;
+
+    using Bucket = unordered_map<uint64_t, vector<size_t>>;
+
+    static uint64_t mix(uint64_t h, uint64_t v) {
+        h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        return h;
+    }
+
+    struct Cell {
+        int64_t cell;
+        int8_t near;
+    };
+
+    static Cell quantize(T value) {
+        if constexpr (ScalarTraits<T>::exact) {
+            return {static_cast<int64_t>(value), 0};
+        } else {
+            const double v = static_cast<double>(value);
+            const double q = floor(v / CELL);
+            if (!(fabs(q) < 4e18)) {
+                // Для очень больших значений шаг double больше EPS: равны только совпадающие.
+                uint64_t bits;
+                const double canonical = v == 0.0 ? 0.0 : v;
+                memcpy(&bits, &canonical, sizeof(bits));
+                return {static_cast<int64_t>(bits), 0};
+            }
+            // Смещение внутри ячейки v - q * CELL при больших |v| теряет точность больше EPS,
+            // поэтому соседняя ячейка определяется тем же floor, что и сама ячейка:
+            // округление монотонно, и равная с допуском точка попадёт в одну из проверенных.
+            const int8_t near = floor((v - EPS) / CELL) != q ? -1 : (floor((v + EPS) / CELL) != q ? 1 : 0);
+            return {static_cast<int64_t>(q), near};
+        }
+    }
+
+    // Хеши всех ключей, под которыми может лежать равная фигура; первый — собственный ключ.
+    static void probeKeys(const Figure<T>& figure, vector<uint64_t>& keys) {
+        const Point<T>* points = figure.getPoints();
+        const size_t n = figure.getSize();
+        Cell cells[10];
+        size_t nearIndex[MAX_NEAR];
+        size_t nearCount = 0;
+        for (size_t k = 0; k < n; ++k) {
+            cells[2 * k] = quantize(points[k].x);
+            cells[2 * k + 1] = quantize(points[k].y);
+        }
+        for (size_t c = 0; c < 2 * n; ++c)
+            if (cells[c].near != 0 && nearCount < MAX_NEAR)
+                nearIndex[nearCount++] = c;
+
+        keys.clear();
+        for (size_t mask = 0; mask < (size_t(1) << nearCount); ++mask) {
+            uint64_t h = mix(0, static_cast<uint64_t>(figure.kind()));
+            size_t bit = 0;
+            for (size_t c = 0; c < 2 * n; ++c) {
+                int64_t cell = cells[c].cell;
+                if (bit < nearCount && nearIndex[bit] == c) {
+                    if (mask & (size_t(1) << bit))
+                        cell += cells[c].near;
+                    ++bit;
+                }
+                h = mix(h, static_cast<uint64_t>(cell));
+            }
+            keys.push_back(h);
+        }
+    }
+
+    static bool same(const Figure<T>& a, const Figure<T>& b) {
+        if (a.kind() != b.kind() || a.getSize() != b.getSize()) return false;
+        const Point<T>* p = a.getPoints();
+        const Point<T>* q = b.getPoints();
+        for (size_t k = 0; k < a.getSize(); ++k)
+            if (!(p[k] == q[k])) return false;
+        return true;
+    }
+
+public:
+    explicit Deduplicator(ThreadPool& pool = ThreadPool::instance(), size_t shards = 64, size_t grain = 4096)
+        : pool_(pool), shards_(max<size_t>(shards, 1)), grain_(max<size_t>(grain, 1)) {}
+
+    DedupResult group(const Array<T>& array) const {
+        const size_t n = array.getSize();
+        DedupResult result;
+        result.representative.resize(n);
+
+        // Собственный ключ каждой фигуры; ключи соседних ячеек считаются при поиске.
+        vector<uint64_t> own(n);
+        pool_.parallelFor(n, grain_, [&](size_t begin, size_t end) {
+            vector<uint64_t> keys;
+            for (size_t i = begin; i < end; ++i) {
+                if (!array[i]) continue;
+                probeKeys(*array[i], keys);
+                own[i] = keys.front();
+            }
+        });
+
+        // Шарды по хешу ключа строятся независимо; индексы в корзинах идут по возрастанию.
+        vector<vector<size_t>> shardItems(shards_);
+        for (size_t i = 0; i < n; ++i)
+            if (array[i])
+                shardItems[own[i] % shards_].push_back(i);
+        vector<Bucket> buckets(shards_);
+        pool_.parallelFor(shards_, 1, [&](size_t begin, size_t end) {
+            for (size_t s = begin; s < end; ++s) {
+                buckets[s].reserve(shardItems[s].size());
+                for (size_t i : shardItems[s])
+                    buckets[s][own[i]].push_back(i);
+            }
+        });
+
+        // Для каждой фигуры — наименьший индекс равной ей фигуры (возможно, она сама).
+        vector<size_t> firstEqual(n);
+        pool_.parallelFor(n, grain_, [&](size_t begin, size_t end) {
+            vector<uint64_t> keys;
+            for (size_t i = begin; i < end; ++i) {
+                firstEqual[i] = i;
+                if (!array[i]) continue;
+                probeKeys(*array[i], keys);
+                for (uint64_t key : keys) {
+                    const Bucket& bucket = buckets[key % shards_];
+                    auto it = bucket.find(key);
+                    if (it == bucket.end()) continue;
+                    for (size_t j : it->second) {
+                        if (j >= firstEqual[i]) break;
+                        if (same(*array[j], *array[i])) {
+                            firstEqual[i] = j;
+                            break;
+                        }
+                    }
+                }
+            }
+        });
+
+        // Равенство с допуском не транзитивно: если найденная фигура сама не представитель,
+        // ищем первого равного представителя среди кандидатов (редкий путь).
+        vector<char> isRepresentative(n, 0);
+        vector<uint64_t> keys;
+        for (size_t i = 0; i < n; ++i) {
+            size_t rep = firstEqual[i];
+            if (array[i] && rep != i && !isRepresentative[rep]) {
+                rep = i;
+                probeKeys(*array[i], keys);
+                for (uint64_t key : keys) {
+                    const Bucket& bucket = buckets[key % shards_];
+                    auto it = bucket.find(key);
+                    if (it == bucket.end()) continue;
+                    for (size_t j : it->second) {
+                        if (j >= rep) break;
+                        if (isRepresentative[j] && same(*array[j], *array[i])) {
+                            rep = j;
+                            break;
+                        }
+                    }
+                }
+            }
+            result.representative[i] = rep;
+            if (rep == i) {
+                isRepresentative[i] = 1;
+                if (array[i])
+                    result.unique.push_back(i);
+            } else {
+                ++result.duplicates;
+            }
+        }
+        return result;
+    }
+
+    // Представители групп в исходном порядке; фигуры не копируются.
+    Array<T> unique(const Array<T>& array) const {
+        const DedupResult result = group(array);
+        Array<T> out(max<size_t>(result.unique.size(), 2));
+        for (size_t i : result.unique)
+            out.addFigure(array[i]);
+        return out;
+    }
+
+    // Дубликаты заменяются указателем на фигуру-представителя: одна копия вершин на группу.
+    // Ячейка представителя тоже помечается общей, иначе transform и mutableFigure
+    // изменили бы фигуру на месте сразу для всей группы.
+    // Возвращает число заменённых ячеек.
+    size_t shareDuplicates(Array<T>& array) const {
+        const DedupResult result = group(array);
+        for (size_t i = 0; i < result.representative.size(); ++i) {
+            const size_t rep = result.representative[i];
+            if (rep == i) continue;
+            const shared_ptr<Figure<T>> figure = array[rep];
+            array.setFigure(i, figure);
+            array.setFigure(rep, figure);
+        }
+        return result.duplicates;
+    }
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "affine.h"
+#include "instrumentation.h"
 #include "point.h" 
 #include <memory>
 #include <iostream>
@@ -7,94 +9,181 @@
 #include <type_traits> 
 #include <concepts>    
 #include <utility>     
+#include <algorithm>
+#include <array>
+#include <cstdint>
 
 
 using namespace std;
 
+enum class FigureKind : uint8_t {
+    Rhombus,
+    Trapezoid,
+    Pentagon
+};
+
+// Корень, пригодный для вычислений во время компиляции (метод Ньютона);
+// может отличаться от sqrt в последнем знаке.
+constexpr double constexprSqrt(double x) {
+    if (!(x > 0.0) || x == INFINITY) return x > 0.0 ? x : 0.0;
+    double cur = x > 1.0 ? x : 1.0;
+    double prev = 0.0;
+    while (true) {
+        const double next = (cur + x / cur) / 2.0;
+        if (next == cur || next == prev) return next < cur ? next : cur;
+        prev = cur;
+        cur = next;
+    }
+}
+
+// Удвоенная ориентированная площадь; для целых T вычисляется точно.
 template <Scalar T>
-class Figure {
-protected:
-    unique_ptr<Point<T>[]> points_;
-    size_t size_ = 0;
+constexpr typename ScalarTraits<T>::Wide doubledSignedArea(const Point<T>* points, size_t n) {
+    using Wide = typename ScalarTraits<T>::Wide;
+    Wide a = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const auto& p1 = points[i];
+        const auto& p2 = points[i + 1 == n ? 0 : i + 1];
+        a += (static_cast<Wide>(p1.x) * static_cast<Wide>(p2.y) -
+              static_cast<Wide>(p2.x) * static_cast<Wide>(p1.y));
+    }
+    return a;
+}
 
-public:
+template <Scalar T>
+constexpr double shoelaceArea(const Point<T>* points, size_t n) {
+    if (n < 3) return 0.0;
+    const auto a = doubledSignedArea(points, n);
+    return static_cast<double>(a < 0 ? -a : a) / 2.0;
+}
 
-    Figure() = default;
+template <Scalar T>
+constexpr Point<T> vertexCenter(const Point<T>* points, size_t n) {
+    T cx = 0, cy = 0;
+    for (size_t i = 0; i < n; ++i) {
+        cx += points[i].x;
+        cy += points[i].y;
+    }
+    return Point<T>(cx / static_cast<T>(n), cy / static_cast<T>(n));
+}
 
-    virtual ~Figure() = default;
+// Точка с рациональными координатами (x / den, y / den) для целых T.
+template <Scalar T>
+    requires ScalarTraits<T>::exact
+struct RationalPoint {
+    using Wide = typename ScalarTraits<T>::Wide;
 
-    Figure(const Figure& other) {
-        size_ = other.size_;
-        if (size_ > 0) {
-            points_ = make_unique<Point<T>[]>(size_);
-            for (size_t i = 0; i < size_; ++i) {
-                points_[i] = other.points_[i];
-            }
-        }
+    Wide x = 0;
+    Wide y = 0;
+    Wide den = 1;
+
+    constexpr bool operator==(const RationalPoint& o) const {
+        return x * o.den == o.x * den && y * o.den == o.y * den;
     }
 
-    Figure& operator=(const Figure& other) {
-        if (this == &other) {
-            return *this;
-        }
-        size_ = other.size_;
-        if (size_ > 0) {
-            points_ = make_unique<Point<T>[]>(size_);
-            for (size_t i = 0; i < size_; ++i) {
-                points_[i] = other.points_[i];
-            }
-        } else {
-            points_.reset();
-        }
-        return *this;
+    constexpr Point<double> toDouble() const {
+        return Point<double>(static_cast<double>(x) / static_cast<double>(den),
+                             static_cast<double>(y) / static_cast<double>(den));
+    }
+};
+
+template <Scalar T>
+    requires ScalarTraits<T>::exact
+constexpr RationalPoint<T> exactCenter(const Point<T>* points, size_t n) {
+    RationalPoint<T> c;
+    for (size_t i = 0; i < n; ++i) {
+        c.x += points[i].x;
+        c.y += points[i].y;
     }
+    c.den = static_cast<typename RationalPoint<T>::Wide>(n);
+    return c;
+}
+
+template <Scalar T>
+struct BoundingBox {
+    Point<T> lo;
+    Point<T> hi;
 
-    Figure(Figure&& other) noexcept
-        : points_(move(other.points_)), size_(other.size_) {
-        other.size_ = 0;
+    constexpr bool intersects(const BoundingBox& o) const {
+        return lo.x <= o.hi.x && o.lo.x <= hi.x && lo.y <= o.hi.y && o.lo.y <= hi.y;
     }
 
-    Figure& operator=(Figure&& other) noexcept {
-        if (this == &other) {
-            return *this;
-        }
-        points_ = move(other.points_);
-        size_ = other.size_;
-        other.size_ = 0;
-        return *this;
+    constexpr bool contains(const Point<T>& p) const {
+        return lo.x <= p.x && p.x <= hi.x && lo.y <= p.y && p.y <= hi.y;
+    }
+
+    constexpr BoundingBox merged(const BoundingBox& o) const {
+        return {Point<T>(min(lo.x, o.lo.x), min(lo.y, o.lo.y)),
+                Point<T>(max(hi.x, o.hi.x), max(hi.y, o.hi.y))};
+    }
+
+    constexpr double distance2(const Point<T>& p) const {
+        double dx = max({static_cast<double>(lo.x) - p.x, 0.0, static_cast<double>(p.x) - hi.x});
+        double dy = max({static_cast<double>(lo.y) - p.y, 0.0, static_cast<double>(p.y) - hi.y});
+        return dx * dx + dy * dy;
+    }
+};
+
+template <Scalar T>
+constexpr BoundingBox<T> boundingBox(const Point<T>* points, size_t n) {
+    BoundingBox<T> box{points[0], points[0]};
+    for (size_t i = 1; i < n; ++i) {
+        box.lo.x = min(box.lo.x, points[i].x);
+        box.lo.y = min(box.lo.y, points[i].y);
+        box.hi.x = max(box.hi.x, points[i].x);
+        box.hi.y = max(box.hi.y, points[i].y);
     }
+    return box;
+}
+
+template <Scalar T>
+class Figure {
+public:
+
+    constexpr Figure() = default;
+
+    constexpr virtual ~Figure() = default;
 
+    Figure(const Figure& other) = default;
+    Figure& operator=(const Figure& other) = default;
+    Figure(Figure&& other) noexcept = default;
+    Figure& operator=(Figure&& other) noexcept = default;
 
-    virtual double getArea() const = 0;
-    virtual Point<T> getCenter() const = 0;
+
+    constexpr virtual double getArea() const = 0;
+    constexpr virtual Point<T> getCenter() const = 0;
     virtual void print(ostream& os) const = 0;
     virtual void read(istream& is) = 0;
-    virtual bool operator==(const Figure<T>& other) const = 0;
+    constexpr virtual bool operator==(const Figure<T>& other) const = 0;
     virtual unique_ptr<Figure<T>> clone() const = 0;
+    constexpr virtual FigureKind kind() const = 0;
+    constexpr virtual size_t getSize() const = 0;
+    constexpr virtual const Point<T>* getPoints() const = 0;
+    virtual void transform(const Affine2D& m) = 0;
 
+    void translate(T dx, T dy) {
+        transform(Affine2D::translation(static_cast<double>(dx), static_cast<double>(dy)));
+    }
 
-    virtual operator double() const {
-        return getArea();
+    void rotate(double angle, const Point<T>& center = Point<T>()) {
+        transform(Affine2D::rotation(angle, static_cast<double>(center.x), static_cast<double>(center.y)));
     }
 
-    size_t getSize() const {
-        return size_;
+    void scale(double sx, double sy, const Point<T>& center = Point<T>()) {
+        transform(Affine2D::scaling(sx, sy, static_cast<double>(center.x), static_cast<double>(center.y)));
     }
 
-    const Point<T>* getPoints() const {
-        return points_.get();
+
+    constexpr virtual operator double() const {
+        return getArea();
     }
 
-    double polygonArea() const {
-        if (size_ < 3) return 0.0;
-        double a = 0.0;
-        for (size_t i = 0; i < size_; ++i) {
-            const auto& p1 = points_[i];
-            const auto& p2 = points_[(i + 1) % size_];
-            a += (static_cast<double>(p1.x) * static_cast<double>(p2.y) -
-                  static_cast<double>(p2.x) * static_cast<double>(p1.y));
-        }
-        return abs(a) / 2.0;
+    constexpr double polygonArea() const {
+        return shoelaceArea(getPoints(), getSize());
+    }
+
+    constexpr virtual BoundingBox<T> getBoundingBox() const {
+        return boundingBox(getPoints(), getSize());
     }
 
     friend ostream& operator<<(ostream& os, const Figure<T>& f) {
@@ -106,4 +195,131 @@ public:
         f.read(is);
         return is;
     }
-};
\ No newline at end of file
+};
+
+template <Scalar T, size_t N>
+class FixedFigure : public Figure<T> {
+private:
+    double timedComputeArea() const {
+        LAB4_COUNT(AreaCalls, 1);
+        LAB4_COUNT(AreaComputations, 1);
+        LAB4_TIME(Area);
+        return computeArea();
+    }
+
+protected:
+    array<Point<T>, N> points_{};
+
+    constexpr virtual double computeArea() const = 0;
+
+    using Wide = typename ScalarTraits<T>::Wide;
+
+    constexpr Wide cross(size_t i) const {
+        const auto& p1 = points_[i];
+        const auto& p2 = points_[i + 1 == N ? 0 : i + 1];
+        return static_cast<Wide>(p1.x) * static_cast<Wide>(p2.y) -
+               static_cast<Wide>(p2.x) * static_cast<Wide>(p1.y);
+    }
+
+    template <size_t... I>
+    constexpr Wide shoelace(index_sequence<I...>) const {
+        return (Wide(0) + ... + cross(I));
+    }
+
+    constexpr double shoelaceArea() const {
+        return static_cast<double>(doubledArea()) / 2.0;
+    }
+
+    void printPoints(ostream& os) const {
+        for (const auto& p : points_) {
+            os << p << " ";
+        }
+    }
+
+    void readPoints(istream& is) {
+        LAB4_COUNT(Reads, 1);
+        LAB4_TIME(Read);
+        for (auto& p : points_) {
+            is >> p;
+        }
+    }
+
+    constexpr bool samePoints(const FixedFigure& other) const {
+        for (size_t i = 0; i < N; ++i) {
+            if (!(points_[i] == other.points_[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    static constexpr size_t arity = N;
+
+    FixedFigure() = default;
+
+    constexpr explicit FixedFigure(const array<Point<T>, N>& points) : points_(points) {}
+
+    constexpr size_t getSize() const override {
+        return N;
+    }
+
+    constexpr const Point<T>* getPoints() const override {
+        return points_.data();
+    }
+
+    constexpr double getArea() const final {
+        if (is_constant_evaluated())
+            return computeArea();
+        return timedComputeArea();
+    }
+
+    constexpr Point<T> getCenter() const final {
+        T cx = 0, cy = 0;
+        for (const auto& p : points_) {
+            cx += p.x;
+            cy += p.y;
+        }
+        return Point<T>(cx / static_cast<T>(N), cy / static_cast<T>(N));
+    }
+
+    constexpr BoundingBox<T> getBoundingBox() const final {
+        return boundingBox(points_.data(), N);
+    }
+
+    // true, если computeArea — площадь многоугольника и при любом аффинном преобразовании
+    // умножается на |det|. Иначе CachedFigure сохраняет площадь только при подобии.
+    constexpr virtual bool areaScalesWithDeterminant() const {
+        return true;
+    }
+
+    // Вершины преобразуются на месте; для целых T округляются.
+    void transform(const Affine2D& m) final {
+        for (auto& p : points_)
+            p = m.apply(p);
+    }
+
+    // Удвоенная площадь по формуле шнурков: для целых T — точное целое.
+    constexpr Wide doubledArea() const {
+        const Wide a = shoelace(make_index_sequence<N>{});
+        return a < 0 ? -a : a;
+    }
+
+    constexpr auto exactCenter() const
+        requires ScalarTraits<T>::exact
+    {
+        return ::exactCenter(points_.data(), N);
+    }
+
+    constexpr const Point<T>& getPoint(size_t index) const {
+        return points_[index];
+    }
+
+    constexpr void setPoint(size_t index, const Point<T>& point) {
+        points_[index] = point;
+    }
+
+    constexpr void setPoints(const array<Point<T>, N>& points) {
+        points_ = points;
+    }
+};
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <charconv>
+#include <iostream>
+#include <locale>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "figure.h"
+#include "point.h"
+
+using namespace std;
+
+// Буфер вывода на основе to_chars: числа форматируются без локали и iostream,
+// данные уходят в поток большими кусками.
+class FormatBuffer {
+private:
+    static constexpr size_t FLUSH_SIZE = 1 << 16;
+
+    ostream& os_;
+    string buffer_;
+
+public:
+    explicit FormatBuffer(ostream& os) : os_(os) {
+        buffer_.reserve(FLUSH_SIZE + 256);
+    }
+
+    ~FormatBuffer() {
+        flush();
+    }
+
+    FormatBuffer(const FormatBuffer&) = delete;
+    FormatBuffer& operator=(const FormatBuffer&) = delete;
+
+    void flush() {
+        if (!buffer_.empty()) {
+            os_.write(buffer_.data(), static_cast<streamsize>(buffer_.size()));
+            buffer_.clear();
+        }
+    }
+
+    FormatBuffer& operator<<(string_view text) {
+        buffer_.append(text);
+        if (buffer_.size() >= FLUSH_SIZE) flush();
+        return *this;
+    }
+
+    FormatBuffer& operator<<(char c) {
+        buffer_.push_back(c);
+        return *this;
+    }
+
+    // precision < 0 — кратчайшая точная запись, иначе как у ostream по умолчанию (%g).
+    template <Scalar V>
+    void number(V value, int precision = 6) {
+        char text[64];
+        to_chars_result r;
+        if constexpr (is_same_v<V, char> || is_same_v<V, signed char> || is_same_v<V, unsigned char>) {
+            buffer_.push_back(static_cast<char>(value));
+            return;
+        } else if constexpr (is_same_v<V, bool>) {
+            buffer_.push_back(value ? '1' : '0');
+            return;
+        } else if constexpr (is_floating_point_v<V>) {
+            r = precision < 0 ? to_chars(text, text + sizeof(text), value)
+                              : to_chars(text, text + sizeof(text), value, chars_format::general, precision);
+        } else {
+            r = to_chars(text, text + sizeof(text), value);
+        }
+        buffer_.append(text, r.ptr);
+    }
+
+    template <Scalar V>
+    void point(const Point<V>& p, int precision = 6) {
+        buffer_.push_back('(');
+        number(p.x, precision);
+        buffer_.append(", ");
+        number(p.y, precision);
+        buffer_.push_back(')');
+    }
+};
+
+inline string_view figureTitle(FigureKind kind) {
+    switch (kind) {
+        case FigureKind::Rhombus:   return "Ромб: ";
+        case FigureKind::Trapezoid: return "Трапеция: ";
+        case FigureKind::Pentagon:  return "5-ти угольник: ";
+    }
+    return "";
+}
+
+inline string_view figureTypeName(FigureKind kind) {
+    switch (kind) {
+        case FigureKind::Rhombus:   return "rhombus";
+        case FigureKind::Trapezoid: return "trapezoid";
+        case FigureKind::Pentagon:  return "pentagon";
+    }
+    return "";
+}
+
+// true, если поток форматирует числа так же, как to_chars в FormatBuffer.
+inline bool hasDefaultFormatting(const ostream& os) {
+    return os.flags() == (ios_base::skipws | ios_base::dec) && os.precision() == 6 &&
+           os.width() == 0 && os.getloc() == locale::classic();
+}
+
+template <Scalar T>
+void formatFigure(FormatBuffer& out, const Figure<T>& figure) {
+    out << figureTitle(figure.kind());
+    const Point<T>* points = figure.getPoints();
+    for (size_t i = 0; i < figure.getSize(); ++i) {
+        out.point(points[i]);
+        out << ' ';
+    }
+}
+
+// Тот же текст, что и Array::printFigures через operator<<. Если у потока изменены
+// флаги, точность или локаль, используется прежний путь через iostream.
+template <typename Figures>
+void writeFigures(ostream& os, const Figures& figures) {
+    if (!hasDefaultFormatting(os)) {
+        size_t i = 0;
+        for (const auto& figure : figures) {
+            os << "Фигура " << i++ << ": ";
+            if (figure) {
+                figure->print(os);
+                os << " | Центр: " << figure->getCenter()
+                   << " | Площадь: " << static_cast<double>(*figure);
+            } else {
+                os << "(пусто)";
+            }
+            os << '\n';
+        }
+        return;
+    }
+
+    FormatBuffer out(os);
+    size_t i = 0;
+    for (const auto& figure : figures) {
+        out << "Фигура ";
+        out.number(i++);
+        out << ": ";
+        if (figure) {
+            formatFigure(out, *figure);
+            out << " | Центр: ";
+            out.point(figure->getCenter());
+            out << " | Площадь: ";
+            out.number(static_cast<double>(*figure));
+        } else {
+            out << "(пусто)";
+        }
+        out << '\n';
+    }
+}
+
+// CSV: index,type,area,center_x,center_y,x1,y1,...,x5,y5 (у четырёхугольников x5,y5 пустые).
+template <typename Figures>
+void writeCsv(ostream& os, const Figures& figures) {
+    FormatBuffer out(os);
+    out << "index,type,area,center_x,center_y,x1,y1,x2,y2,x3,y3,x4,y4,x5,y5\n";
+    size_t i = 0;
+    for (const auto& figure : figures) {
+        const size_t index = i++;
+        if (!figure) continue;
+        out.number(index);
+        out << ',' << figureTypeName(figure->kind()) << ',';
+        out.number(figure->getArea(), -1);
+        const auto center = figure->getCenter();
+        out << ',';
+        out.number(center.x, -1);
+        out << ',';
+        out.number(center.y, -1);
+        const auto* points = figure->getPoints();
+        for (size_t k = 0; k < 5; ++k) {
+            out << ',';
+            if (k < figure->getSize()) {
+                out.number(points[k].x, -1);
+                out << ',';
+                out.number(points[k].y, -1);
+            } else {
+                out << ',';
+            }
+        }
+        out << '\n';
+    }
+}
+
+// JSON Lines: один объект на строку, пустые ячейки пропускаются.
+template <typename Figures>
+void writeJsonLines(ostream& os, const Figures& figures) {
+    FormatBuffer out(os);
+    size_t i = 0;
+    for (const auto& figure : figures) {
+        const size_t index = i++;
+        if (!figure) continue;
+        out << "{\"index\":";
+        out.number(index);
+        out << ",\"type\":\"" << figureTypeName(figure->kind()) << "\",\"area\":";
+        out.number(figure->getArea(), -1);
+        const auto center = figure->getCenter();
+        out << ",\"center\":[";
+        out.number(center.x, -1);
+        out << ',';
+        out.number(center.y, -1);
+        out << "],\"points\":[";
+        const auto* points = figure->getPoints();
+        for (size_t k = 0; k < figure->getSize(); ++k) {
+            out << (k ? ",[" : "[");
+            out.number(points[k].x, -1);
+            out << ',';
+            out.number(points[k].y, -1);
+            out << ']';
+        }
+        out << "]}\n";
+    }
+}
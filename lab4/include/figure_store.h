@@ -0,0 +1,228 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "affine.h"
+#include "area_kernel.h"
+#include "array.h"
+#include "figure.h"
+#include "pentagon.h"
+#include "point.h"
+#include "rhombus.h"
+#include "thread_pool.h"
+#include "trapezoid.h"
+
+using namespace std;
+
+// Координаты фигур одного типа: x[k][i], y[k][i] — k-я вершина i-й фигуры.
+template <Scalar T, size_t N>
+struct CoordBlock {
+    array<vector<T>, N> x;
+    array<vector<T>, N> y;
+
+    size_t size() const { return x[0].size(); }
+
+    void reserve(size_t n) {
+        for (size_t k = 0; k < N; ++k) {
+            x[k].reserve(n);
+            y[k].reserve(n);
+        }
+    }
+
+    void transform(const Affine2D& m, size_t begin, size_t end) {
+        for (size_t k = 0; k < N; ++k)
+            batchAffine(x[k].data() + begin, y[k].data() + begin, end - begin, m);
+    }
+
+    void push(const Point<T>* points) {
+        for (size_t k = 0; k < N; ++k) {
+            x[k].push_back(points[k].x);
+            y[k].push_back(points[k].y);
+        }
+    }
+
+    Point<T> point(size_t i, size_t k) const {
+        return Point<T>(x[k][i], y[k][i]);
+    }
+};
+
+template <Scalar T>
+class FigureStore {
+private:
+    CoordBlock<T, 4> rhombi_;
+    CoordBlock<T, 4> trapezoids_;
+    CoordBlock<T, 5> pentagons_;
+    vector<FigureKind> kinds_;
+    vector<size_t> slots_;
+
+    template <size_t N>
+    static void shoelace(const CoordBlock<T, N>& block, double* out) {
+        const T* xs[N];
+        const T* ys[N];
+        for (size_t k = 0; k < N; ++k) {
+            xs[k] = block.x[k].data();
+            ys[k] = block.y[k].data();
+        }
+        batchShoelaceArea<T, N>(xs, ys, block.size(), out);
+    }
+
+    static void rhombusAreas(const CoordBlock<T, 4>& block, double* out) {
+        if constexpr (ScalarTraits<T>::exact) {
+            // Для целых площадь ромба точно равна площади четырёхугольника по шнуркам.
+            shoelace(block, out);
+            return;
+        }
+        const size_t n = block.size();
+        for (size_t i = 0; i < n; ++i) {
+            T dx1 = block.x[0][i] - block.x[2][i];
+            T dy1 = block.y[0][i] - block.y[2][i];
+            T dx2 = block.x[1][i] - block.x[3][i];
+            T dy2 = block.y[1][i] - block.y[3][i];
+            T d1 = sqrt(dx1 * dx1 + dy1 * dy1);
+            T d2 = sqrt(dx2 * dx2 + dy2 * dy2);
+            out[i] = static_cast<double>(d1 * d2) / 2.0;
+        }
+    }
+
+    template <size_t N>
+    static void centers(const CoordBlock<T, N>& block, Point<T>* out) {
+        const size_t n = block.size();
+        for (size_t i = 0; i < n; ++i) {
+            T cx = 0, cy = 0;
+            for (size_t k = 0; k < N; ++k) {
+                cx += block.x[k][i];
+                cy += block.y[k][i];
+            }
+            out[i] = Point<T>(cx / static_cast<T>(N), cy / static_cast<T>(N));
+        }
+    }
+
+    template <typename V>
+    void scatter(const V* r, const V* t, const V* p, V* out) const {
+        for (size_t i = 0; i < kinds_.size(); ++i) {
+            switch (kinds_[i]) {
+                case FigureKind::Rhombus:   out[i] = r[slots_[i]]; break;
+                case FigureKind::Trapezoid: out[i] = t[slots_[i]]; break;
+                case FigureKind::Pentagon:  out[i] = p[slots_[i]]; break;
+            }
+        }
+    }
+
+public:
+    FigureStore() = default;
+
+    explicit FigureStore(const Array<T>& array) {
+        kinds_.reserve(array.getSize());
+        slots_.reserve(array.getSize());
+        for (const auto& figure : array) {
+            if (figure)
+                addFigure(*figure);
+        }
+    }
+
+    void addFigure(const Figure<T>& figure) {
+        const Point<T>* points = figure.getPoints();
+        kinds_.push_back(figure.kind());
+        switch (figure.kind()) {
+            case FigureKind::Rhombus:
+                slots_.push_back(rhombi_.size());
+                rhombi_.push(points);
+                break;
+            case FigureKind::Trapezoid:
+                slots_.push_back(trapezoids_.size());
+                trapezoids_.push(points);
+                break;
+            case FigureKind::Pentagon:
+                slots_.push_back(pentagons_.size());
+                pentagons_.push(points);
+                break;
+        }
+    }
+
+    size_t getSize() const { return kinds_.size(); }
+
+    FigureKind getKind(size_t index) const { return kinds_[index]; }
+    size_t getSlot(size_t index) const { return slots_[index]; }
+
+    const CoordBlock<T, 4>& rhombi() const { return rhombi_; }
+    const CoordBlock<T, 4>& trapezoids() const { return trapezoids_; }
+    const CoordBlock<T, 5>& pentagons() const { return pentagons_; }
+
+    // Преобразует все вершины на месте векторным ядром batchAffine.
+    void transform(const Affine2D& m) {
+        rhombi_.transform(m, 0, rhombi_.size());
+        trapezoids_.transform(m, 0, trapezoids_.size());
+        pentagons_.transform(m, 0, pentagons_.size());
+    }
+
+    void transform(const Affine2D& m, ThreadPool& pool, size_t grain = 4096) {
+        const size_t r = rhombi_.size(), t = trapezoids_.size();
+        pool.parallelFor(kinds_.size(), grain, [&](size_t begin, size_t end) {
+            // Общий диапазон [0, size) делится на части по блокам: ромбы, трапеции, пятиугольники.
+            auto part = [&](auto& block, size_t offset) {
+                const size_t from = max(begin, offset), to = min(end, offset + block.size());
+                if (from < to)
+                    block.transform(m, from - offset, to - offset);
+            };
+            part(rhombi_, 0);
+            part(trapezoids_, r);
+            part(pentagons_, r + t);
+        });
+    }
+
+    vector<double> getAreas() const {
+        vector<double> r(rhombi_.size()), t(trapezoids_.size()), p(pentagons_.size());
+        rhombusAreas(rhombi_, r.data());
+        shoelace(trapezoids_, t.data());
+        shoelace(pentagons_, p.data());
+        vector<double> out(kinds_.size());
+        scatter(r.data(), t.data(), p.data(), out.data());
+        return out;
+    }
+
+    vector<Point<T>> getCenters() const {
+        vector<Point<T>> r(rhombi_.size()), t(trapezoids_.size()), p(pentagons_.size());
+        centers(rhombi_, r.data());
+        centers(trapezoids_, t.data());
+        centers(pentagons_, p.data());
+        vector<Point<T>> out(kinds_.size());
+        scatter(r.data(), t.data(), p.data(), out.data());
+        return out;
+    }
+
+    double getAllArea() const {
+        double total = 0.0;
+        for (double a : getAreas())
+            total += a;
+        return total;
+    }
+
+    Array<T> toArray() const {
+        Array<T> array(kinds_.empty() ? 2 : kinds_.size());
+        for (size_t i = 0; i < kinds_.size(); ++i) {
+            const size_t s = slots_[i];
+            switch (kinds_[i]) {
+                case FigureKind::Rhombus:
+                    array.addFigure(make_shared<Rhombus<T>>(
+                        rhombi_.point(s, 0), rhombi_.point(s, 1),
+                        rhombi_.point(s, 2), rhombi_.point(s, 3)));
+                    break;
+                case FigureKind::Trapezoid:
+                    array.addFigure(make_shared<Trapezoid<T>>(
+                        trapezoids_.point(s, 0), trapezoids_.point(s, 1),
+                        trapezoids_.point(s, 2), trapezoids_.point(s, 3)));
+                    break;
+                case FigureKind::Pentagon:
+                    array.addFigure(make_shared<Pentagon<T>>(
+                        pentagons_.point(s, 0), pentagons_.point(s, 1), pentagons_.point(s, 2),
+                        pentagons_.point(s, 3), pentagons_.point(s, 4)));
+                    break;
+            }
+        }
+        return array;
+    }
+};
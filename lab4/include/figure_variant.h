@@ -0,0 +1,139 @@
+#pragma once
+
+#include <memory>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "array.h"
+#include "figure.h"
+#include "pentagon.h"
+#include "point.h"
+#include "rhombus.h"
+#include "trapezoid.h"
+
+using namespace std;
+
+// Закрытый набор фигур, хранимых по значению. Фигуры объявлены final,
+// поэтому вызовы внутри visit разрешаются статически и встраиваются.
+template <Scalar T>
+using FigureVariant = variant<Rhombus<T>, Trapezoid<T>, Pentagon<T>>;
+
+template <Scalar T>
+double figureArea(const FigureVariant<T>& figure) {
+    return visit([](const auto& f) { return f.getArea(); }, figure);
+}
+
+template <Scalar T>
+Point<T> figureCenter(const FigureVariant<T>& figure) {
+    return visit([](const auto& f) { return f.getCenter(); }, figure);
+}
+
+template <Scalar T>
+bool sameFigure(const FigureVariant<T>& a, const FigureVariant<T>& b) {
+    if (a.index() != b.index()) return false;
+    return visit([&b](const auto& f) {
+        using Shape = decay_t<decltype(f)>;
+        const Point<T>* p = f.getPoints();
+        const Point<T>* q = get<Shape>(b).getPoints();
+        for (size_t i = 0; i < Shape::arity; ++i)
+            if (!(p[i] == q[i])) return false;
+        return true;
+    }, a);
+}
+
+template <Scalar T>
+FigureVariant<T> toVariant(const Figure<T>& figure) {
+    const Point<T>* p = figure.getPoints();
+    switch (figure.kind()) {
+        case FigureKind::Rhombus:
+            return Rhombus<T>(p[0], p[1], p[2], p[3]);
+        case FigureKind::Trapezoid:
+            return Trapezoid<T>(p[0], p[1], p[2], p[3]);
+        default:
+            return Pentagon<T>(p[0], p[1], p[2], p[3], p[4]);
+    }
+}
+
+template <Scalar T>
+class VariantArray {
+private:
+    vector<FigureVariant<T>> figures_;
+
+public:
+    VariantArray() = default;
+
+    explicit VariantArray(const Array<T>& array) {
+        figures_.reserve(array.getSize());
+        for (const auto& figure : array)
+            if (figure)
+                figures_.push_back(toVariant(*figure));
+    }
+
+    void addFigure(const FigureVariant<T>& figure) {
+        figures_.push_back(figure);
+    }
+
+    void addFigure(FigureVariant<T>&& figure) {
+        figures_.push_back(move(figure));
+    }
+
+    // Фигура строится прямо в хранилище: без кучи и без счётчиков ссылок.
+    template <typename Shape, typename... Args>
+    Shape& emplaceFigure(Args&&... args) {
+        return get<Shape>(figures_.emplace_back(in_place_type<Shape>, forward<Args>(args)...));
+    }
+
+    void removeFigure(size_t index) {
+        if (index >= figures_.size()) return;
+        figures_.erase(figures_.begin() + index);
+    }
+
+    const FigureVariant<T>& getFigure(size_t index) const { return figures_[index]; }
+    const FigureVariant<T>& operator[](size_t index) const { return figures_[index]; }
+
+    size_t getSize() const { return figures_.size(); }
+
+    void reserve(size_t capacity) { figures_.reserve(capacity); }
+
+    auto begin() const { return figures_.begin(); }
+    auto end() const { return figures_.end(); }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& figure : figures_)
+            visit(fn, figure);
+    }
+
+    double getAllArea() const {
+        double total = 0.0;
+        for (const auto& figure : figures_)
+            total += figureArea(figure);
+        return total;
+    }
+
+    vector<double> getAreas() const {
+        vector<double> areas;
+        areas.reserve(figures_.size());
+        for (const auto& figure : figures_)
+            areas.push_back(figureArea(figure));
+        return areas;
+    }
+
+    vector<Point<T>> getCenters() const {
+        vector<Point<T>> centers;
+        centers.reserve(figures_.size());
+        for (const auto& figure : figures_)
+            centers.push_back(figureCenter(figure));
+        return centers;
+    }
+
+    Array<T> toArray() const {
+        Array<T> array(figures_.empty() ? 2 : figures_.size());
+        for (const auto& figure : figures_)
+            visit([&array](const auto& f) {
+                array.addFigure(make_shared<decay_t<decltype(f)>>(f));
+            }, figure);
+        return array;
+    }
+};
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+
+using namespace std;
+
+// Счётчики и гистограммы задержек горячих путей Array и Figure.
+// Включаются при сборке с -DLAB4_INSTRUMENTATION (опция CMake LAB4_INSTRUMENTATION);
+// без неё макросы LAB4_COUNT и LAB4_TIME ничего не генерируют, а снимок всегда нулевой.
+namespace instrumentation {
+
+#ifdef LAB4_INSTRUMENTATION
+inline constexpr bool enabled = true;
+#else
+inline constexpr bool enabled = false;
+#endif
+
+enum class Counter : size_t {
+    Allocations,
+    Resizes,
+    Clones,
+    AreaCalls,
+    AreaComputations,
+    Reads,
+    BytesParsed,
+    Count
+};
+
+enum class Operation : size_t {
+    Resize,
+    Clone,
+    Read,
+    Area,
+    Count
+};
+
+inline constexpr size_t COUNTERS = static_cast<size_t>(Counter::Count);
+inline constexpr size_t OPERATIONS = static_cast<size_t>(Operation::Count);
+
+inline constexpr array<string_view, COUNTERS> COUNTER_NAMES = {
+    "allocations", "resizes", "clones", "area_calls", "area_computations", "reads", "bytes_parsed"};
+
+inline constexpr array<string_view, OPERATIONS> OPERATION_NAMES = {"resize", "clone", "read", "area"};
+
+// Корзина k содержит длительности из [2^(k-1), 2^k) наносекунд, корзина 0 — ровно 0 нс.
+struct Histogram {
+    static constexpr size_t BUCKETS = 40;
+
+    array<uint64_t, BUCKETS> buckets{};
+    uint64_t count = 0;
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+
+    static size_t bucketOf(uint64_t ns) {
+        return min<size_t>(static_cast<size_t>(bit_width(ns)), BUCKETS - 1);
+    }
+
+    // Верхняя граница корзины, в которую попадает доля q всех измерений.
+    uint64_t percentile(double q) const {
+        const uint64_t target = static_cast<uint64_t>(q * static_cast<double>(count));
+        uint64_t seen = 0;
+        for (size_t k = 0; k < BUCKETS; ++k) {
+            seen += buckets[k];
+            if (seen > target || (seen == count && count > 0))
+                return k == 0 ? 0 : (uint64_t(1) << k) - 1;
+        }
+        return 0;
+    }
+};
+
+struct Snapshot {
+    array<uint64_t, COUNTERS> counters{};
+    array<Histogram, OPERATIONS> latency{};
+
+    uint64_t counter(Counter c) const {
+        return counters[static_cast<size_t>(c)];
+    }
+
+    const Histogram& histogram(Operation op) const {
+        return latency[static_cast<size_t>(op)];
+    }
+};
+
+// Все поля — отдельные атомики с relaxed-порядком, каждый счётчик в своей кеш-линии,
+// чтобы потоки не мешали друг другу.
+class Registry {
+private:
+    struct alignas(64) Cell {
+        atomic<uint64_t> value{0};
+    };
+
+    struct alignas(64) Latency {
+        atomic<uint64_t> buckets[Histogram::BUCKETS] = {};
+        atomic<uint64_t> count{0};
+        atomic<uint64_t> totalNs{0};
+        atomic<uint64_t> maxNs{0};
+    };
+
+    Cell counters_[COUNTERS];
+    Latency latency_[OPERATIONS];
+
+    Registry() = default;
+
+public:
+    Registry(const Registry&) = delete;
+    Registry& operator=(const Registry&) = delete;
+
+    static Registry& instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    void add(Counter c, uint64_t n = 1) {
+        counters_[static_cast<size_t>(c)].value.fetch_add(n, memory_order_relaxed);
+    }
+
+    void record(Operation op, uint64_t ns) {
+        Latency& l = latency_[static_cast<size_t>(op)];
+        l.buckets[Histogram::bucketOf(ns)].fetch_add(1, memory_order_relaxed);
+        l.count.fetch_add(1, memory_order_relaxed);
+        l.totalNs.fetch_add(ns, memory_order_relaxed);
+        uint64_t prev = l.maxNs.load(memory_order_relaxed);
+        while (prev < ns && !l.maxNs.compare_exchange_weak(prev, ns, memory_order_relaxed)) {}
+    }
+
+    // Снимок не атомарен целиком: при параллельной записи поля могут отставать друг от друга.
+    Snapshot snapshot() const {
+        Snapshot s;
+        for (size_t i = 0; i < COUNTERS; ++i)
+            s.counters[i] = counters_[i].value.load(memory_order_relaxed);
+        for (size_t op = 0; op < OPERATIONS; ++op) {
+            const Latency& l = latency_[op];
+            Histogram& h = s.latency[op];
+            for (size_t k = 0; k < Histogram::BUCKETS; ++k)
+                h.buckets[k] = l.buckets[k].load(memory_order_relaxed);
+            h.count = l.count.load(memory_order_relaxed);
+            h.totalNs = l.totalNs.load(memory_order_relaxed);
+            h.maxNs = l.maxNs.load(memory_order_relaxed);
+        }
+        return s;
+    }
+
+    void reset() {
+        for (auto& c : counters_)
+            c.value.store(0, memory_order_relaxed);
+        for (auto& l : latency_) {
+            for (auto& b : l.buckets)
+                b.store(0, memory_order_relaxed);
+            l.count.store(0, memory_order_relaxed);
+            l.totalNs.store(0, memory_order_relaxed);
+            l.maxNs.store(0, memory_order_relaxed);
+        }
+    }
+};
+
+class ScopedTimer {
+private:
+    Operation op_;
+    chrono::steady_clock::time_point start_;
+
+public:
+    explicit ScopedTimer(Operation op) : op_(op), start_(chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        const auto ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start_).count();
+        Registry::instance().record(op_, static_cast<uint64_t>(ns > 0 ? ns : 0));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+inline Snapshot snapshot() {
+    return Registry::instance().snapshot();
+}
+
+inline void reset() {
+    Registry::instance().reset();
+}
+
+// Гистограмма в JSON — только непустые корзины: {"upper_ns": граница, "count": число}.
+inline void writeJson(ostream& os, const Snapshot& s) {
+    os << "{\"enabled\":" << (enabled ? "true" : "false") << ",\"counters\":{";
+    for (size_t i = 0; i < COUNTERS; ++i)
+        os << (i ? "," : "") << '"' << COUNTER_NAMES[i] << "\":" << s.counters[i];
+    os << "},\"latency\":{";
+    for (size_t op = 0; op < OPERATIONS; ++op) {
+        const Histogram& h = s.latency[op];
+        os << (op ? "," : "") << '"' << OPERATION_NAMES[op] << "\":{\"count\":" << h.count
+           << ",\"total_ns\":" << h.totalNs << ",\"max_ns\":" << h.maxNs
+           << ",\"p50_ns\":" << h.percentile(0.5) << ",\"p99_ns\":" << h.percentile(0.99) << ",\"buckets\":[";
+        bool first = true;
+        for (size_t k = 0; k < Histogram::BUCKETS; ++k) {
+            if (!h.buckets[k]) continue;
+            os << (first ? "" : ",") << "{\"upper_ns\":" << (k == 0 ? 0 : (uint64_t(1) << k) - 1)
+               << ",\"count\":" << h.buckets[k] << '}';
+            first = false;
+        }
+        os << "]}";
+    }
+    os << "}}";
+}
+
+inline void writeJson(ostream& os) {
+    writeJson(os, snapshot());
+}
+
+}
+
+#define LAB4_CONCAT_IMPL(a, b) a##b
+#define LAB4_CONCAT(a, b) LAB4_CONCAT_IMPL(a, b)
+
+#ifdef LAB4_INSTRUMENTATION
+#define LAB4_COUNT(counter, n) \
+    ::instrumentation::Registry::instance().add(::instrumentation::Counter::counter, (n))
+#define LAB4_TIME(operation) \
+    ::instrumentation::ScopedTimer LAB4_CONCAT(lab4Timer, __LINE__)(::instrumentation::Operation::operation)
+#else
+#define LAB4_COUNT(counter, n) static_cast<void>(0)
+#define LAB4_TIME(operation) static_cast<void>(0)
+#endif
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "array.h"
+#include "figure.h"
+#include "point.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+inline constexpr size_t SORT_GRAIN = 1 << 14;
+
+// Ключ — площадь фигуры.
+inline constexpr auto byArea = [](const auto& figure) {
+    return figure.getArea();
+};
+
+// Ключ — квадрат расстояния от центра фигуры до точки (x, y): порядок тот же, что по расстоянию.
+inline auto byCenterDistance(double x = 0.0, double y = 0.0) {
+    return [x, y](const auto& figure) {
+        const auto c = figure.getCenter();
+        const double dx = static_cast<double>(c.x) - x, dy = static_cast<double>(c.y) - y;
+        return dx * dx + dy * dy;
+    };
+}
+
+namespace ordering_detail {
+
+struct KeyIndex {
+    double key;
+    size_t index;
+};
+
+// При равных ключах порядок — по индексу, поэтому результат не зависит от числа потоков.
+struct Ascending {
+    bool operator()(const KeyIndex& a, const KeyIndex& b) const {
+        return a.key < b.key || (a.key == b.key && a.index < b.index);
+    }
+};
+
+struct Descending {
+    bool operator()(const KeyIndex& a, const KeyIndex& b) const {
+        return a.key > b.key || (a.key == b.key && a.index < b.index);
+    }
+};
+
+// Ключи считаются один раз, параллельно; пустые ячейки Array пропускаются.
+template <Scalar T, typename Key>
+vector<KeyIndex> computeKeys(const Array<T>& array, const Key& key, ThreadPool& pool, size_t grain) {
+    vector<KeyIndex> all(array.getSize());
+    vector<char> present(array.getSize(), 0);
+    pool.parallelFor(array.getSize(), grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            if (!array[i]) continue;
+            all[i] = {static_cast<double>(key(*array[i])), i};
+            present[i] = 1;
+        }
+    });
+    size_t out = 0;
+    for (size_t i = 0; i < all.size(); ++i)
+        if (present[i])
+            all[out++] = all[i];
+    all.resize(out);
+    return all;
+}
+
+// Сортировка слиянием: отрезки по grain сортируются параллельно, затем сливаются попарно.
+template <typename Less>
+void parallelSort(vector<KeyIndex>& items, Less less, ThreadPool& pool, size_t grain) {
+    const size_t n = items.size();
+    grain = max<size_t>(grain, 1);
+    if (n <= grain || pool.getThreadCount() <= 1) {
+        sort(items.begin(), items.end(), less);
+        return;
+    }
+    pool.parallelFor(n, grain, [&](size_t begin, size_t end) {
+        sort(items.begin() + begin, items.begin() + end, less);
+    });
+    vector<KeyIndex> buffer(n);
+    for (size_t width = grain; width < n; width *= 2) {
+        const size_t pairs = (n + 2 * width - 1) / (2 * width);
+        pool.parallelFor(pairs, 1, [&](size_t begin, size_t end) {
+            for (size_t p = begin; p < end; ++p) {
+                const size_t lo = p * 2 * width;
+                const size_t mid = min(n, lo + width), hi = min(n, lo + 2 * width);
+                merge(items.begin() + lo, items.begin() + mid, items.begin() + mid, items.begin() + hi,
+                      buffer.begin() + lo, less);
+            }
+        });
+        items.swap(buffer);
+    }
+}
+
+inline vector<size_t> indices(const vector<KeyIndex>& items, size_t count) {
+    vector<size_t> result(count);
+    for (size_t i = 0; i < count; ++i)
+        result[i] = items[i].index;
+    return result;
+}
+
+}
+
+// Индексы непустых фигур в порядке ключа.
+template <Scalar T, typename Key>
+vector<size_t> sortedIndices(const Array<T>& array, const Key& key, bool descending = false,
+                             ThreadPool& pool = ThreadPool::instance(), size_t grain = SORT_GRAIN) {
+    auto items = ordering_detail::computeKeys(array, key, pool, grain);
+    if (descending)
+        ordering_detail::parallelSort(items, ordering_detail::Descending(), pool, grain);
+    else
+        ordering_detail::parallelSort(items, ordering_detail::Ascending(), pool, grain);
+    return ordering_detail::indices(items, items.size());
+}
+
+// k фигур с наибольшим (largest) или наименьшим ключом, упорядоченные от крайнего.
+// Отбор через nth_element за O(n), сортируются только k выбранных.
+template <Scalar T, typename Key>
+vector<size_t> topK(const Array<T>& array, size_t k, const Key& key, bool largest = true,
+                    ThreadPool& pool = ThreadPool::instance(), size_t grain = SORT_GRAIN) {
+    auto items = ordering_detail::computeKeys(array, key, pool, grain);
+    k = min(k, items.size());
+    auto select = [&](auto less) {
+        if (k < items.size())
+            nth_element(items.begin(), items.begin() + k, items.end(), less);
+        sort(items.begin(), items.begin() + k, less);
+    };
+    if (largest)
+        select(ordering_detail::Descending());
+    else
+        select(ordering_detail::Ascending());
+    return ordering_detail::indices(items, k);
+}
+
+// Индекс фигуры, которая стояла бы n-й (с нуля) при сортировке по возрастанию ключа.
+template <Scalar T, typename Key>
+size_t nthIndex(const Array<T>& array, size_t n, const Key& key,
+                ThreadPool& pool = ThreadPool::instance(), size_t grain = SORT_GRAIN) {
+    auto items = ordering_detail::computeKeys(array, key, pool, grain);
+    if (n >= items.size())
+        throw runtime_error("Индекс вне диапазона");
+    nth_element(items.begin(), items.begin() + n, items.end(), ordering_detail::Ascending());
+    return items[n].index;
+}
+
+// Переставляет фигуры Array в порядке ключа (пустые ячейки — в конец); фигуры не копируются,
+// настройки Array и счётчик удалённых ячеек сохраняются.
+template <Scalar T, typename Key>
+void sortFigures(Array<T>& array, const Key& key, bool descending = false,
+                 ThreadPool& pool = ThreadPool::instance(), size_t grain = SORT_GRAIN) {
+    array.permute(sortedIndices(array, key, descending, pool, grain));
+}
+
+// Array с постоянным вторичным индексом по ключу. Индекс обновляется при каждом
+// addFigure/removeFigure за O(log n); фигуры изменять нельзя, иначе ключ устареет.
+template <Scalar T>
+class IndexedArray {
+public:
+    using Key = function<double(const Figure<T>&)>;
+
+private:
+    Array<T> array_;
+    Key key_;
+    multimap<double, shared_ptr<Figure<T>>> byKey_;
+
+    void index(const shared_ptr<Figure<T>>& figure) {
+        if (figure)
+            byKey_.emplace(key_(*figure), figure);
+    }
+
+public:
+    explicit IndexedArray(Key key = byArea) : key_(move(key)) {}
+
+    IndexedArray(const Array<T>& array, Key key = byArea) : array_(array.getCapacity()), key_(move(key)) {
+        for (const auto& figure : array)
+            addFigure(figure);
+    }
+
+    void addFigure(const shared_ptr<Figure<T>>& figure) {
+        array_.addFigure(figure);
+        index(figure);
+    }
+
+    void removeFigure(size_t index) {
+        const auto figure = array_.getFigure(index);
+        if (figure) {
+            auto [first, last] = byKey_.equal_range(key_(*figure));
+            for (auto it = first; it != last; ++it) {
+                if (it->second == figure) {
+                    byKey_.erase(it);
+                    break;
+                }
+            }
+        }
+        array_.removeFigure(index);
+    }
+
+    size_t getSize() const { return array_.getSize(); }
+    shared_ptr<Figure<T>> getFigure(size_t index) const { return array_.getFigure(index); }
+    shared_ptr<Figure<T>> operator[](size_t index) const { return array_[index]; }
+    const Array<T>& getArray() const { return array_; }
+
+    // Обход в порядке возрастания ключа: begin()/end() по парам (ключ, фигура).
+    auto begin() const { return byKey_.begin(); }
+    auto end() const { return byKey_.end(); }
+
+    // n-я (с нуля) по возрастанию ключа фигура; O(n) по обходу дерева.
+    shared_ptr<Figure<T>> nth(size_t n) const {
+        if (n >= byKey_.size()) return nullptr;
+        return next(byKey_.begin(), static_cast<ptrdiff_t>(n))->second;
+    }
+
+    // k фигур с наибольшим ключом, от наибольшего.
+    vector<shared_ptr<Figure<T>>> top(size_t k) const {
+        vector<shared_ptr<Figure<T>>> result;
+        result.reserve(min(k, byKey_.size()));
+        for (auto it = byKey_.rbegin(); it != byKey_.rend() && result.size() < k; ++it)
+            result.push_back(it->second);
+        return result;
+    }
+
+    // Фигуры с ключом из [lo, hi] по возрастанию ключа.
+    vector<shared_ptr<Figure<T>>> range(double lo, double hi) const {
+        vector<shared_ptr<Figure<T>>> result;
+        for (auto it = byKey_.lower_bound(lo); it != byKey_.end() && it->first <= hi; ++it)
+            result.push_back(it->second);
+        return result;
+    }
+};
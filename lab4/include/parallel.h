@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "array.h"
+#include "figure.h"
+#include "point.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+inline constexpr size_t DEFAULT_GRAIN = 4096;
+
+// Попарное суммирование с фиксированным деревом: отрезок делится пополам до 8 элементов.
+// Дерево зависит только от n, поэтому сумма не зависит ни от числа потоков, ни от grain.
+template <typename Fn>
+double pairwiseSum(size_t begin, size_t n, const Fn& value) {
+    if (n <= 8) {
+        double s = 0.0;
+        for (size_t i = begin; i < begin + n; ++i)
+            s += value(i);
+        return s;
+    }
+    const size_t half = n / 2;
+    return pairwiseSum(begin, half, value) + pairwiseSum(begin + half, n - half, value);
+}
+
+namespace parallel_detail {
+
+inline void collectLeaves(size_t begin, size_t n, size_t grain, vector<pair<size_t, size_t>>& leaves) {
+    if (n <= grain || n <= 8) {
+        leaves.emplace_back(begin, n);
+        return;
+    }
+    const size_t half = n / 2;
+    collectLeaves(begin, half, grain, leaves);
+    collectLeaves(begin + half, n - half, grain, leaves);
+}
+
+inline double combineLeaves(size_t n, size_t grain, const vector<double>& sums, size_t& next) {
+    if (n <= grain || n <= 8)
+        return sums[next++];
+    const size_t half = n / 2;
+    double left = combineLeaves(half, grain, sums, next);
+    return left + combineLeaves(n - half, grain, sums, next);
+}
+
+}
+
+template <typename Fn>
+double parallelPairwiseSum(size_t n, const Fn& value, ThreadPool& pool, size_t grain) {
+    if (n == 0) return 0.0;
+    grain = max<size_t>(1, grain);
+    vector<pair<size_t, size_t>> leaves;
+    parallel_detail::collectLeaves(0, n, grain, leaves);
+    vector<double> sums(leaves.size());
+    pool.parallelFor(leaves.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            sums[i] = pairwiseSum(leaves[i].first, leaves[i].second, value);
+    });
+    size_t next = 0;
+    return parallel_detail::combineLeaves(n, grain, sums, next);
+}
+
+template <Scalar T>
+double parallelAllArea(const Array<T>& array, ThreadPool& pool = ThreadPool::instance(),
+                       size_t grain = DEFAULT_GRAIN) {
+    const auto* figures = array.begin();
+    return parallelPairwiseSum(array.getSize(), [figures](size_t i) {
+        return figures[i] ? static_cast<double>(*figures[i]) : 0.0;
+    }, pool, grain);
+}
+
+template <Scalar T>
+Point<double> parallelCentroid(const Array<T>& array, ThreadPool& pool = ThreadPool::instance(),
+                               size_t grain = DEFAULT_GRAIN) {
+    const auto* figures = array.begin();
+    const size_t n = array.getSize();
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i)
+        if (figures[i]) ++count;
+    if (count == 0) return Point<double>();
+
+    vector<Point<T>> centers(n);
+    pool.parallelFor(n, grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+            if (figures[i]) centers[i] = figures[i]->getCenter();
+    });
+    double sx = parallelPairwiseSum(n, [&](size_t i) {
+        return figures[i] ? static_cast<double>(centers[i].x) : 0.0;
+    }, pool, grain);
+    double sy = parallelPairwiseSum(n, [&](size_t i) {
+        return figures[i] ? static_cast<double>(centers[i].y) : 0.0;
+    }, pool, grain);
+    return Point<double>(sx / count, sy / count);
+}
+
+// Гистограмма площадей: bins равных корзин на [minArea, maxArea], значения вне отрезка
+// попадают в крайние корзины.
+template <Scalar T>
+vector<size_t> parallelAreaHistogram(const Array<T>& array, size_t bins, double minArea, double maxArea,
+                                     ThreadPool& pool = ThreadPool::instance(),
+                                     size_t grain = DEFAULT_GRAIN) {
+    vector<size_t> histogram(bins, 0);
+    if (bins == 0 || array.getSize() == 0) return histogram;
+
+    const auto* figures = array.begin();
+    const size_t n = array.getSize();
+    grain = max<size_t>(1, grain);
+    const size_t chunks = (n + grain - 1) / grain;
+    vector<vector<size_t>> partial(chunks, vector<size_t>(bins, 0));
+    const double width = maxArea > minArea ? (maxArea - minArea) / bins : 1.0;
+
+    pool.parallelFor(n, grain, [&](size_t begin, size_t end) {
+        auto& local = partial[begin / grain];
+        for (size_t i = begin; i < end; ++i) {
+            if (!figures[i]) continue;
+            double bin = floor((static_cast<double>(*figures[i]) - minArea) / width);
+            local[static_cast<size_t>(clamp(bin, 0.0, static_cast<double>(bins - 1)))]++;
+        }
+    });
+    for (const auto& local : partial)
+        for (size_t b = 0; b < bins; ++b)
+            histogram[b] += local[b];
+    return histogram;
+}
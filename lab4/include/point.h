@@ -3,6 +3,7 @@
 #include <concepts>
 #include <iostream>
 #include <cmath>
+#include <cstdint>
 
 
 using namespace std;
@@ -10,23 +11,51 @@ using namespace std;
 template<typename T>
 concept Scalar = is_arithmetic_v<T>;
 
+// Арифметика по типу координат. Для вещественных типов — как раньше: накопление в double
+// и сравнение с допуском. Для целых — точные вычисления без плавающей точки.
+template<Scalar T>
+struct ScalarTraits {
+    using Wide = double;
+    static constexpr bool exact = false;
+
+    static constexpr bool equal(T a, T b) {
+        constexpr double EPS = 1e-9;
+        const double d = static_cast<double>(a) - static_cast<double>(b);
+        return (d < 0 ? -d : d) < EPS;
+    }
+};
+
+__extension__ typedef __int128 int128_t;
+
+// Суммы произведений координат по многоугольнику помещаются в Wide без переполнения:
+// для 8- и 16-битных координат хватает int64_t, для 32-битных (до 2^63 на слагаемое)
+// и 64-битных нужен 128-битный накопитель.
+template<Scalar T>
+    requires is_integral_v<T>
+struct ScalarTraits<T> {
+    using Wide = conditional_t<(sizeof(T) <= 2), int64_t, int128_t>;
+    static constexpr bool exact = true;
+
+    static constexpr bool equal(T a, T b) {
+        return a == b;
+    }
+};
+
 template<Scalar T>
 struct Point {
     T x{0};
     T y{0};
 
     Point() = default;
-    Point(T x_, T y_) : x(x_), y(y_) {}
+    constexpr Point(T x_, T y_) : x(x_), y(y_) {}
 
     Point(const Point& other) = default;
     Point(Point&& other) noexcept = default;
     Point& operator=(const Point& other) = default;
     Point& operator=(Point&& other) noexcept = default;
 
-    bool operator==(const Point& o) const {
-        constexpr double EPS = 1e-9;
-        return abs(static_cast<double>(x) - static_cast<double>(o.x)) < EPS
-            && abs(static_cast<double>(y) - static_cast<double>(o.y)) < EPS;
+    constexpr bool operator==(const Point& o) const {
+        return ScalarTraits<T>::equal(x, o.x) && ScalarTraits<T>::equal(y, o.y);
     }
 };
 
@@ -10,118 +10,85 @@
 using namespace std;
 
 template <Scalar T>
-class Rhombus : public Figure<T> {
+class Rhombus final : public FixedFigure<T, 4> {
 private:
-    static T distance(const Point<T>& a, const Point<T>& b) {
+    static constexpr T distance(const Point<T>& a, const Point<T>& b) {
         T dx = a.x - b.x;
         T dy = a.y - b.y;
+        if (is_constant_evaluated())
+            return static_cast<T>(constexprSqrt(static_cast<double>(dx * dx + dy * dy)));
         return sqrt(dx * dx + dy * dy);
     }
 
-public:
-    Rhombus() {
-        this->size_ = 4;
-        this->points_ = make_unique<Point<T>[]>(4);
+protected:
+    constexpr double computeArea() const override {
+        return diagonalArea(this->points_.data());
     }
-    Rhombus(const Point<T>& p1, const Point<T>& p2,
-        const Point<T>& p3, const Point<T>& p4) {
-
-        this->size_ = 4;
-        this->points_ = make_unique<Point<T>[]>(4);
 
-        this->points_[0] = p1;
-        this->points_[1] = p2;
-        this->points_[2] = p3;
-        this->points_[3] = p4;
+public:
+    // Формула через длины диагоналей верна только для ромба, а ромб остаётся ромбом лишь при подобии.
+    constexpr bool areaScalesWithDeterminant() const override {
+        return false;
     }
 
-    Rhombus(const Rhombus& other) {
-        this->size_ = other.size_;
-        this->points_ = make_unique<Point<T>[]>(this->size_);
-        for (size_t i = 0; i < this->size_; ++i) {
-            this->points_[i] = other.points_[i];
+    // Для целых T — точно, как половина модуля векторного произведения диагоналей.
+    static constexpr double diagonalArea(const Point<T>* points) {
+        if constexpr (ScalarTraits<T>::exact) {
+            using Wide = typename ScalarTraits<T>::Wide;
+            const Wide dx1 = static_cast<Wide>(points[2].x) - points[0].x;
+            const Wide dy1 = static_cast<Wide>(points[2].y) - points[0].y;
+            const Wide dx2 = static_cast<Wide>(points[3].x) - points[1].x;
+            const Wide dy2 = static_cast<Wide>(points[3].y) - points[1].y;
+            const Wide a = dx1 * dy2 - dy1 * dx2;
+            return static_cast<double>(a < 0 ? -a : a) / 2.0;
         }
+        T d1 = distance(points[0], points[2]);
+        T d2 = distance(points[1], points[3]);
+        return static_cast<double>(d1 * d2) / 2.0;
     }
 
-    Rhombus& operator=(const Rhombus& other) {
-        if (this == &other) {
-            return *this;
-        }
-        this->size_ = other.size_;
-        this->points_ = make_unique<Point<T>[]>(this->size_);
-        for (size_t i = 0; i < this->size_; ++i) {
-            this->points_[i] = other.points_[i];
-        }
-        return *this;
-    }
+    constexpr Rhombus() = default;
 
-    Rhombus(Rhombus&& other) noexcept {
-        this->size_ = other.size_;
-        this->points_ = move(other.points_); 
-        other.size_ = 0;
-    }
+    constexpr Rhombus(const Point<T>& p1, const Point<T>& p2,
+        const Point<T>& p3, const Point<T>& p4)
+        : FixedFigure<T, 4>({p1, p2, p3, p4}) {}
 
-    Rhombus& operator=(Rhombus&& other) noexcept {
-        if (this == &other) {
-            return *this;
-        }
-        this->size_ = other.size_;
-        this->points_ = move(other.points_);
-        other.size_ = 0;
-        return *this;
-    }
+    Rhombus(const Rhombus& other) = default;
+    Rhombus& operator=(const Rhombus& other) = default;
+    Rhombus(Rhombus&& other) noexcept = default;
+    Rhombus& operator=(Rhombus&& other) noexcept = default;
 
-    ~Rhombus() = default;
+    constexpr ~Rhombus() = default;
 
-    Point<T> getCenter() const override {
-        T cx = 0, cy = 0;
-        for (size_t i = 0; i < this->size_; ++i) {
-            cx += this->points_[i].x;
-            cy += this->points_[i].y;
-        }
-        return Point<T>(cx / this->size_, cy / this->size_);
-    }
-
-    double getArea() const override {
-        T d1 = distance(this->points_[0], this->points_[2]);
-        T d2 = distance(this->points_[1], this->points_[3]);
-        return static_cast<double>(d1 * d2) / 2.0;
-    }
-
-    operator double() const override {
-        return getArea();
+    constexpr operator double() const override {
+        return this->getArea();
     }
 
     void print(ostream& os) const override {
         os << "Ромб: ";
-        for (size_t i = 0; i < this->size_; ++i) {
-            os << this->points_[i] << " ";
-        }
+        this->printPoints(os);
     }
 
     void read(istream& is) override {
         cout << "Введите 4 точки ромба (x y): " << endl;
-        this->size_ = 4;
-        this->points_ = make_unique<Point<T>[]>(4);
-        for (size_t i = 0; i < this->size_; ++i) {
-            is >> this->points_[i];
-        }
+        this->readPoints(is);
     }
 
-    bool operator==(const Figure<T>& other) const override {
+    constexpr bool operator==(const Figure<T>& other) const override {
         const Rhombus<T>* rhombus = dynamic_cast<const Rhombus<T>*>(&other);
         if (!rhombus) {
             return false;
         }
-        for (size_t i = 0; i < this->size_; ++i) {
-            if (!(this->points_[i] == rhombus->points_[i])) {
-                return false;
-            }
-        }
-        return true;
+        return this->samePoints(*rhombus);
     }
 
     unique_ptr<Figure<T>> clone() const override {
+        LAB4_COUNT(Clones, 1);
+        LAB4_TIME(Clone);
         return make_unique<Rhombus<T>>(*this);
     }
-};
\ No newline at end of file
+
+    constexpr FigureKind kind() const override {
+        return FigureKind::Rhombus;
+    }
+};
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "array.h"
+#include "figure.h"
+#include "pentagon.h"
+#include "point.h"
+#include "rhombus.h"
+#include "trapezoid.h"
+
+using namespace std;
+
+// Формат сцены (little-endian):
+//   SceneHeader
+//   SceneRecord[figureCount]  — тип, число вершин и индекс первой вершины
+//   Point<T>[vertexCount]     — вершины всех фигур подряд
+// Запись i соответствует ячейке i исходного Array; пустой ячейке соответствует
+// запись с kind == SCENE_EMPTY_KIND и arity == 0, без вершин.
+inline constexpr char SCENE_MAGIC[4] = {'L', '4', 'S', 'C'};
+inline constexpr uint16_t SCENE_VERSION = 1;
+inline constexpr uint8_t SCENE_EMPTY_KIND = 0xFF;
+
+enum class CoordType : uint8_t {
+    Int32 = 1,
+    Int64 = 2,
+    Float32 = 3,
+    Float64 = 4
+};
+
+template <Scalar T>
+constexpr CoordType coordTypeOf() {
+    if constexpr (is_same_v<T, int32_t>) return CoordType::Int32;
+    else if constexpr (is_same_v<T, int64_t>) return CoordType::Int64;
+    else if constexpr (is_same_v<T, float>) return CoordType::Float32;
+    else {
+        static_assert(is_same_v<T, double>, "unsupported coordinate type for scene files");
+        return CoordType::Float64;
+    }
+}
+
+struct SceneHeader {
+    char magic[4];
+    uint16_t version;
+    uint8_t coordType;
+    uint8_t coordSize;
+    uint64_t figureCount;
+    uint64_t vertexCount;
+    uint64_t reserved;
+};
+
+struct SceneRecord {
+    uint64_t firstVertex;
+    uint8_t kind;
+    uint8_t arity;
+    uint8_t reserved[6];
+};
+
+static_assert(sizeof(SceneHeader) == 32);
+static_assert(sizeof(SceneRecord) == 16);
+
+inline size_t arityOf(FigureKind kind) {
+    return kind == FigureKind::Pentagon ? 5 : 4;
+}
+
+template <Scalar T>
+void writeScene(const Array<T>& array, const string& path) {
+    static_assert(sizeof(Point<T>) == 2 * sizeof(T));
+    if constexpr (endian::native != endian::little)
+        throw runtime_error("Сцены поддерживаются только на little-endian платформах");
+
+    vector<SceneRecord> records;
+    records.reserve(array.getSize());
+    uint64_t vertexCount = 0;
+    for (const auto& figure : array) {
+        SceneRecord record{};
+        record.firstVertex = vertexCount;
+        record.kind = figure ? static_cast<uint8_t>(figure->kind()) : SCENE_EMPTY_KIND;
+        record.arity = figure ? static_cast<uint8_t>(figure->getSize()) : 0;
+        records.push_back(record);
+        vertexCount += record.arity;
+    }
+
+    SceneHeader header{};
+    memcpy(header.magic, SCENE_MAGIC, sizeof(header.magic));
+    header.version = SCENE_VERSION;
+    header.coordType = static_cast<uint8_t>(coordTypeOf<T>());
+    header.coordSize = sizeof(T);
+    header.figureCount = records.size();
+    header.vertexCount = vertexCount;
+
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out)
+        throw runtime_error("Не удалось открыть файл сцены: " + path);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(SceneRecord));
+    for (const auto& figure : array) {
+        if (!figure) continue;
+        out.write(reinterpret_cast<const char*>(figure->getPoints()), figure->getSize() * sizeof(Point<T>));
+    }
+    if (!out)
+        throw runtime_error("Ошибка записи файла сцены: " + path);
+}
+
+template <Scalar T>
+struct FigureView {
+    FigureKind kind;
+    size_t arity;
+    const Point<T>* points;
+
+    // Пустая ячейка исходного Array.
+    bool empty() const {
+        return arity == 0;
+    }
+
+    double getArea() const {
+        if (empty()) return 0.0;
+        if (kind == FigureKind::Rhombus)
+            return Rhombus<T>::diagonalArea(points);
+        return shoelaceArea(points, arity);
+    }
+
+    Point<T> getCenter() const {
+        return empty() ? Point<T>() : vertexCenter(points, arity);
+    }
+
+    unique_ptr<Figure<T>> toFigure() const {
+        if (empty()) return nullptr;
+        const Point<T>* p = points;
+        switch (kind) {
+            case FigureKind::Rhombus:
+                return make_unique<Rhombus<T>>(p[0], p[1], p[2], p[3]);
+            case FigureKind::Trapezoid:
+                return make_unique<Trapezoid<T>>(p[0], p[1], p[2], p[3]);
+            case FigureKind::Pentagon:
+                return make_unique<Pentagon<T>>(p[0], p[1], p[2], p[3], p[4]);
+        }
+        return nullptr;
+    }
+};
+
+template <Scalar T>
+class SceneFile {
+private:
+    const byte* data_ = nullptr;
+    size_t length_ = 0;
+    const SceneRecord* records_ = nullptr;
+    const Point<T>* vertices_ = nullptr;
+    size_t figureCount_ = 0;
+
+    void unmap() {
+        if (data_)
+            munmap(const_cast<byte*>(data_), length_);
+        data_ = nullptr;
+        length_ = 0;
+    }
+
+    void validate() {
+        if (length_ < sizeof(SceneHeader))
+            throw runtime_error("Файл сцены слишком короткий");
+        SceneHeader header;
+        memcpy(&header, data_, sizeof(header));
+        if (memcmp(header.magic, SCENE_MAGIC, sizeof(header.magic)) != 0)
+            throw runtime_error("Неверная сигнатура файла сцены");
+        if (header.version != SCENE_VERSION)
+            throw runtime_error("Неподдерживаемая версия файла сцены");
+        if (header.coordType != static_cast<uint8_t>(coordTypeOf<T>()) || header.coordSize != sizeof(T))
+            throw runtime_error("Тип координат файла сцены не совпадает с T");
+
+        const uint64_t recordsEnd = sizeof(SceneHeader) + header.figureCount * sizeof(SceneRecord);
+        const uint64_t expected = recordsEnd + header.vertexCount * sizeof(Point<T>);
+        if (header.figureCount > length_ || header.vertexCount > length_ || expected != length_)
+            throw runtime_error("Размер файла сцены не совпадает с заголовком");
+
+        records_ = reinterpret_cast<const SceneRecord*>(data_ + sizeof(SceneHeader));
+        vertices_ = reinterpret_cast<const Point<T>*>(data_ + recordsEnd);
+        figureCount_ = header.figureCount;
+        for (size_t i = 0; i < figureCount_; ++i) {
+            const SceneRecord& r = records_[i];
+            const bool empty = r.kind == SCENE_EMPTY_KIND && r.arity == 0;
+            if (!empty && (r.kind > static_cast<uint8_t>(FigureKind::Pentagon) ||
+                           r.arity != arityOf(static_cast<FigureKind>(r.kind))))
+                throw runtime_error("Повреждённая запись в файле сцены");
+            // Сумма firstVertex + arity может переполниться, поэтому сравнение через разность.
+            if (r.firstVertex > header.vertexCount || r.arity > header.vertexCount - r.firstVertex)
+                throw runtime_error("Повреждённая запись в файле сцены");
+        }
+    }
+
+public:
+    explicit SceneFile(const string& path) {
+        static_assert(sizeof(Point<T>) == 2 * sizeof(T));
+        if constexpr (endian::native != endian::little)
+            throw runtime_error("Сцены поддерживаются только на little-endian платформах");
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw runtime_error("Не удалось открыть файл сцены: " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            throw runtime_error("Не удалось прочитать файл сцены: " + path);
+        }
+        length_ = static_cast<size_t>(st.st_size);
+        void* mapped = mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            length_ = 0;
+            throw runtime_error("Не удалось отобразить файл сцены: " + path);
+        }
+        data_ = static_cast<const byte*>(mapped);
+        madvise(mapped, length_, MADV_SEQUENTIAL);
+        try {
+            validate();
+        } catch (...) {
+            unmap();
+            throw;
+        }
+    }
+
+    ~SceneFile() {
+        unmap();
+    }
+
+    SceneFile(const SceneFile&) = delete;
+    SceneFile& operator=(const SceneFile&) = delete;
+
+    SceneFile(SceneFile&& other) noexcept
+        : data_(other.data_), length_(other.length_), records_(other.records_),
+          vertices_(other.vertices_), figureCount_(other.figureCount_) {
+        other.data_ = nullptr;
+        other.length_ = 0;
+        other.figureCount_ = 0;
+    }
+
+    SceneFile& operator=(SceneFile&& other) noexcept {
+        if (this == &other) return *this;
+        unmap();
+        data_ = other.data_;
+        length_ = other.length_;
+        records_ = other.records_;
+        vertices_ = other.vertices_;
+        figureCount_ = other.figureCount_;
+        other.data_ = nullptr;
+        other.length_ = 0;
+        other.figureCount_ = 0;
+        return *this;
+    }
+
+    size_t getSize() const { return figureCount_; }
+
+    FigureView<T> operator[](size_t index) const {
+        const SceneRecord& r = records_[index];
+        return FigureView<T>{static_cast<FigureKind>(r.kind), r.arity, vertices_ + r.firstVertex};
+    }
+
+    const Point<T>* getVertices() const { return vertices_; }
+
+    // Пустые записи восстанавливаются удалёнными ячейками (Tombstone), как в исходном Array.
+    Array<T> toArray() const {
+        Array<T> array(figureCount_ ? figureCount_ : 2);
+        for (size_t i = 0; i < figureCount_; ++i) {
+            const FigureView<T> view = (*this)[i];
+            if (view.empty())
+                array.addTombstone();
+            else
+                array.addFigure(shared_ptr<Figure<T>>(view.toFigure()));
+        }
+        return array;
+    }
+};
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+#include "array.h"
+#include "figure.h"
+#include "figure_format.h"
+
+using namespace std;
+
+// Массив фигур из сегментов фиксированного размера: при росте добавляется новый сегмент,
+// уже добавленные элементы не перемещаются. Запас памяти — не больше одного сегмента,
+// пик при росте — текущий объём плюс сегмент (у Array — старый и новый буфер одновременно).
+template <Scalar T>
+class SegmentedArray {
+private:
+    using Segment = unique_ptr<shared_ptr<Figure<T>>[]>;
+
+    vector<Segment> segments_;
+    size_t shift_;
+    size_t size_ = 0;
+
+    size_t segmentSize() const { return size_t(1) << shift_; }
+
+    shared_ptr<Figure<T>>& slot(size_t index) {
+        return segments_[index >> shift_][index & (segmentSize() - 1)];
+    }
+
+    const shared_ptr<Figure<T>>& slot(size_t index) const {
+        return segments_[index >> shift_][index & (segmentSize() - 1)];
+    }
+
+public:
+    class Iterator {
+    private:
+        const SegmentedArray* owner_;
+        size_t index_;
+
+    public:
+        using iterator_category = forward_iterator_tag;
+        using value_type = shared_ptr<Figure<T>>;
+        using difference_type = ptrdiff_t;
+        using pointer = const shared_ptr<Figure<T>>*;
+        using reference = const shared_ptr<Figure<T>>&;
+
+        Iterator() : owner_(nullptr), index_(0) {}
+        Iterator(const SegmentedArray* owner, size_t index) : owner_(owner), index_(index) {}
+
+        reference operator*() const { return owner_->slot(index_); }
+        pointer operator->() const { return &owner_->slot(index_); }
+
+        Iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++index_;
+            return old;
+        }
+
+        bool operator==(const Iterator& other) const { return index_ == other.index_; }
+    };
+
+    // Размер сегмента округляется вверх до степени двойки.
+    explicit SegmentedArray(size_t segmentSize = 4096)
+        : shift_(static_cast<size_t>(countr_zero(bit_ceil(max<size_t>(segmentSize, 1))))) {}
+
+    explicit SegmentedArray(const Array<T>& array, size_t segmentSize = 4096) : SegmentedArray(segmentSize) {
+        addFigures(array);
+    }
+
+    ~SegmentedArray() = default;
+
+    SegmentedArray(const SegmentedArray& other) : shift_(other.shift_) {
+        reserve(other.size_);
+        for (size_t i = 0; i < other.size_; ++i) {
+            const auto& figure = other.slot(i);
+            slot(i) = figure ? shared_ptr<Figure<T>>(figure->clone().release()) : nullptr;
+        }
+        size_ = other.size_;
+    }
+
+    SegmentedArray(SegmentedArray&& other) noexcept
+        : segments_(move(other.segments_)), shift_(other.shift_), size_(other.size_) {
+        other.size_ = 0;
+    }
+
+    SegmentedArray& operator=(SegmentedArray other) noexcept {
+        swap(segments_, other.segments_);
+        swap(shift_, other.shift_);
+        swap(size_, other.size_);
+        return *this;
+    }
+
+    void reserve(size_t capacity) {
+        while (getCapacity() < capacity)
+            segments_.push_back(Segment(new shared_ptr<Figure<T>>[segmentSize()]));
+    }
+
+    // Освобождает сегменты, целиком лежащие за последним элементом.
+    void shrinkToFit() {
+        const size_t needed = (size_ + segmentSize() - 1) >> shift_;
+        segments_.resize(needed);
+        segments_.shrink_to_fit();
+    }
+
+    void addFigure(const shared_ptr<Figure<T>>& figure) {
+        reserve(size_ + 1);
+        slot(size_++) = figure;
+    }
+
+    void addFigure(shared_ptr<Figure<T>>&& figure) {
+        reserve(size_ + 1);
+        slot(size_++) = move(figure);
+    }
+
+    template <typename Shape>
+        requires derived_from<Shape, Figure<T>>
+    void addFigure(unique_ptr<Shape>&& figure) {
+        addFigure(shared_ptr<Figure<T>>(move(figure)));
+    }
+
+    template <typename Shape, typename... Args>
+        requires derived_from<Shape, Figure<T>>
+    Shape& emplaceFigure(Args&&... args) {
+        auto figure = make_shared<Shape>(forward<Args>(args)...);
+        Shape& result = *figure;
+        addFigure(shared_ptr<Figure<T>>(move(figure)));
+        return result;
+    }
+
+    template <typename Range>
+    void addFigures(const Range& figures) {
+        if constexpr (ranges::forward_range<const Range>)
+            reserve(size_ + static_cast<size_t>(ranges::distance(figures)));
+        for (const auto& figure : figures)
+            addFigure(figure);
+    }
+
+    void removeFigure(size_t index) {
+        if (index >= size_) return;
+        for (size_t i = index; i + 1 < size_; ++i)
+            slot(i) = move(slot(i + 1));
+        slot(--size_).reset();
+    }
+
+    shared_ptr<Figure<T>> getFigure(size_t index) const {
+        if (index >= size_) return nullptr;
+        return slot(index);
+    }
+
+    shared_ptr<Figure<T>> operator[](size_t index) const {
+        return getFigure(index);
+    }
+
+    size_t getSize() const { return size_; }
+    size_t getCapacity() const { return segments_.size() << shift_; }
+    size_t getSegmentSize() const { return segmentSize(); }
+    size_t getSegmentCount() const { return segments_.size(); }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, size_); }
+
+    double getAllArea() const {
+        double total = 0.0;
+        for (size_t i = 0; i < size_; ++i)
+            if (const auto& figure = slot(i))
+                total += static_cast<double>(*figure);
+        return total;
+    }
+
+    void printFigures(ostream& os = cout) const {
+        writeFigures(os, *this);
+    }
+
+    Array<T> toArray() const {
+        Array<T> array(max<size_t>(size_, 1));
+        array.addFigures(*this);
+        return array;
+    }
+};
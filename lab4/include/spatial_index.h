@@ -0,0 +1,323 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <queue>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "array.h"
+#include "figure.h"
+#include "point.h"
+
+using namespace std;
+
+template <Scalar T>
+bool pointInPolygon(const Point<T>* points, size_t n, const Point<T>& p) {
+    const double px = static_cast<double>(p.x), py = static_cast<double>(p.y);
+    bool inside = false;
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        const double xi = static_cast<double>(points[i].x), yi = static_cast<double>(points[i].y);
+        const double xj = static_cast<double>(points[j].x), yj = static_cast<double>(points[j].y);
+        const double cross = (xj - xi) * (py - yi) - (yj - yi) * (px - xi);
+        if (cross == 0.0 && min(xi, xj) <= px && px <= max(xi, xj) && min(yi, yj) <= py && py <= max(yi, yj))
+            return true;
+        if ((yi > py) != (yj > py) && px < (xj - xi) * (py - yi) / (yj - yi) + xi)
+            inside = !inside;
+    }
+    return inside;
+}
+
+template <Scalar T>
+double polygonDistance2(const Point<T>* points, size_t n, const Point<T>& p) {
+    if (pointInPolygon(points, n, p)) return 0.0;
+    const double px = static_cast<double>(p.x), py = static_cast<double>(p.y);
+    double best = INFINITY;
+    for (size_t i = 0; i < n; ++i) {
+        const double ax = static_cast<double>(points[i].x), ay = static_cast<double>(points[i].y);
+        const auto& b = points[i + 1 == n ? 0 : i + 1];
+        const double dx = static_cast<double>(b.x) - ax, dy = static_cast<double>(b.y) - ay;
+        const double len2 = dx * dx + dy * dy;
+        double t = len2 > 0.0 ? ((px - ax) * dx + (py - ay) * dy) / len2 : 0.0;
+        t = clamp(t, 0.0, 1.0);
+        const double ex = ax + t * dx - px, ey = ay + t * dy - py;
+        best = min(best, ex * ex + ey * ey);
+    }
+    return best;
+}
+
+enum class NearestBy {
+    Center,
+    Polygon
+};
+
+// Статическое R-дерево, построенное упаковкой STR (Sort-Tile-Recursive).
+// Хранит сырые указатели на фигуры: исходный Array не должен меняться, пока индекс используется.
+template <Scalar T>
+class RTree {
+private:
+    struct Entry {
+        BoundingBox<T> box;
+        size_t index;
+    };
+
+    struct Node {
+        BoundingBox<T> box;
+        size_t first;
+        size_t count;
+        bool leaf;
+    };
+
+    vector<const Figure<T>*> figures_;
+    vector<Entry> entries_;
+    vector<Node> nodes_;
+    size_t root_ = 0;
+    size_t fanout_;
+
+    template <typename Item>
+    static double midX(const Item& item) {
+        return (static_cast<double>(item.box.lo.x) + static_cast<double>(item.box.hi.x)) / 2.0;
+    }
+
+    template <typename Item>
+    static double midY(const Item& item) {
+        return (static_cast<double>(item.box.lo.y) + static_cast<double>(item.box.hi.y)) / 2.0;
+    }
+
+    template <typename Item>
+    void strSort(vector<Item>& items) const {
+        const size_t pages = (items.size() + fanout_ - 1) / fanout_;
+        const size_t slices = static_cast<size_t>(ceil(sqrt(static_cast<double>(pages))));
+        const size_t sliceSize = slices * fanout_;
+        sort(items.begin(), items.end(), [](const Item& a, const Item& b) { return midX(a) < midX(b); });
+        for (size_t s = 0; s < items.size(); s += sliceSize) {
+            auto last = items.begin() + min(items.size(), s + sliceSize);
+            sort(items.begin() + s, last, [](const Item& a, const Item& b) { return midY(a) < midY(b); });
+        }
+    }
+
+    template <typename Item>
+    vector<Node> pack(const vector<Item>& items, size_t offset, bool leaf) const {
+        vector<Node> parents;
+        for (size_t i = 0; i < items.size(); i += fanout_) {
+            const size_t count = min(fanout_, items.size() - i);
+            BoundingBox<T> box = items[i].box;
+            for (size_t j = 1; j < count; ++j)
+                box = box.merged(items[i + j].box);
+            parents.push_back({box, offset + i, count, leaf});
+        }
+        return parents;
+    }
+
+    template <typename Visit>
+    void visitNode(const Node& node, const BoundingBox<T>& box, Visit& visit) const {
+        if (!node.box.intersects(box)) return;
+        for (size_t i = node.first; i < node.first + node.count; ++i) {
+            if (node.leaf) {
+                if (entries_[i].box.intersects(box))
+                    visit(entries_[i].index);
+            } else {
+                visitNode(nodes_[i], box, visit);
+            }
+        }
+    }
+
+    template <typename Visit>
+    void visit(const BoundingBox<T>& box, Visit&& visit) const {
+        if (!nodes_.empty())
+            visitNode(nodes_[root_], box, visit);
+    }
+
+public:
+    explicit RTree(const Array<T>& array, size_t fanout = 16)
+        : fanout_(max<size_t>(fanout, 2)) {
+        figures_.reserve(array.getSize());
+        entries_.reserve(array.getSize());
+        for (const auto& figure : array) {
+            figures_.push_back(figure.get());
+            if (figure)
+                entries_.push_back({figure->getBoundingBox(), figures_.size() - 1});
+        }
+        if (entries_.empty()) return;
+
+        strSort(entries_);
+        vector<Node> level = pack(entries_, 0, true);
+        while (level.size() > 1) {
+            strSort(level);
+            const size_t offset = nodes_.size();
+            nodes_.insert(nodes_.end(), level.begin(), level.end());
+            level = pack(level, offset, false);
+        }
+        root_ = nodes_.size();
+        nodes_.push_back(level.front());
+    }
+
+    size_t getSize() const { return entries_.size(); }
+
+    // Фигуры, чей ограничивающий прямоугольник пересекается с box.
+    vector<size_t> queryBox(const BoundingBox<T>& box) const {
+        vector<size_t> result;
+        visit(box, [&](size_t index) { result.push_back(index); });
+        sort(result.begin(), result.end());
+        return result;
+    }
+
+    // Фигуры, которые точно содержат точку p (граница включается).
+    vector<size_t> queryPoint(const Point<T>& p) const {
+        vector<size_t> result;
+        visit(BoundingBox<T>{p, p}, [&](size_t index) {
+            const Figure<T>* figure = figures_[index];
+            if (pointInPolygon(figure->getPoints(), figure->getSize(), p))
+                result.push_back(index);
+        });
+        sort(result.begin(), result.end());
+        return result;
+    }
+
+    // k ближайших фигур к p в порядке возрастания расстояния.
+    vector<size_t> nearest(const Point<T>& p, size_t k, NearestBy by = NearestBy::Center) const {
+        vector<size_t> result;
+        if (nodes_.empty() || k == 0) return result;
+
+        // Элемент очереди: расстояние, номер узла или записи, признак «это фигура».
+        using Item = tuple<double, size_t, int>;
+        priority_queue<Item, vector<Item>, greater<Item>> queue;
+        queue.emplace(nodes_[root_].box.distance2(p), root_, 0);
+        while (!queue.empty() && result.size() < k) {
+            auto [d, id, kind] = queue.top();
+            queue.pop();
+            if (kind == 2) {
+                result.push_back(id);
+                continue;
+            }
+            if (kind == 1) {
+                const Figure<T>* figure = figures_[entries_[id].index];
+                double exact;
+                if (by == NearestBy::Center) {
+                    const Point<T> c = figure->getCenter();
+                    const double dx = static_cast<double>(c.x) - p.x, dy = static_cast<double>(c.y) - p.y;
+                    exact = dx * dx + dy * dy;
+                } else {
+                    exact = polygonDistance2(figure->getPoints(), figure->getSize(), p);
+                }
+                queue.emplace(exact, entries_[id].index, 2);
+                continue;
+            }
+            const Node& node = nodes_[id];
+            for (size_t i = node.first; i < node.first + node.count; ++i) {
+                if (node.leaf)
+                    queue.emplace(entries_[i].box.distance2(p), i, 1);
+                else
+                    queue.emplace(nodes_[i].box.distance2(p), i, 0);
+            }
+        }
+        return result;
+    }
+};
+
+// Равномерная сетка: быстрее R-дерева для фигур примерно одного размера.
+// Число ячеек не больше CELLS_PER_FIGURE на фигуру: слишком мелкий cellSize увеличивается.
+template <Scalar T>
+class UniformGrid {
+private:
+    static constexpr double CELLS_PER_FIGURE = 4.0;
+
+    vector<const Figure<T>*> figures_;
+    vector<BoundingBox<T>> boxes_;
+    vector<size_t> cellStart_;
+    vector<size_t> cellItems_;
+    double originX_ = 0.0, originY_ = 0.0;
+    double cellSize_;
+    size_t columns_ = 0, rows_ = 0;
+
+    size_t column(double x) const {
+        return static_cast<size_t>(clamp(floor((x - originX_) / cellSize_), 0.0, static_cast<double>(columns_ - 1)));
+    }
+
+    size_t row(double y) const {
+        return static_cast<size_t>(clamp(floor((y - originY_) / cellSize_), 0.0, static_cast<double>(rows_ - 1)));
+    }
+
+    template <typename Fn>
+    void forCells(const BoundingBox<T>& box, Fn&& fn) const {
+        const size_t c0 = column(box.lo.x), c1 = column(box.hi.x);
+        const size_t r0 = row(box.lo.y), r1 = row(box.hi.y);
+        for (size_t r = r0; r <= r1; ++r)
+            for (size_t c = c0; c <= c1; ++c)
+                fn(r * columns_ + c);
+    }
+
+public:
+    UniformGrid(const Array<T>& array, double cellSize)
+        : cellSize_(cellSize > 0.0 ? cellSize : 1.0) {
+        figures_.reserve(array.getSize());
+        boxes_.reserve(array.getSize());
+        bool first = true;
+        BoundingBox<T> world{};
+        for (const auto& figure : array) {
+            figures_.push_back(figure.get());
+            boxes_.push_back(figure ? figure->getBoundingBox() : BoundingBox<T>{});
+            if (!figure) continue;
+            world = first ? boxes_.back() : world.merged(boxes_.back());
+            first = false;
+        }
+        if (first) return;
+
+        originX_ = static_cast<double>(world.lo.x);
+        originY_ = static_cast<double>(world.lo.y);
+        const double width = static_cast<double>(world.hi.x) - originX_;
+        const double height = static_cast<double>(world.hi.y) - originY_;
+        const double maxCells = CELLS_PER_FIGURE * static_cast<double>(figures_.size());
+        auto cells = [&] { return (floor(width / cellSize_) + 1) * (floor(height / cellSize_) + 1); };
+        if (!isfinite(width) || !isfinite(height))
+            throw runtime_error("Координаты фигур должны быть конечными");
+        if (!(cells() <= maxCells)) {
+            cellSize_ = max({cellSize_, sqrt(width * height / maxCells), width / maxCells, height / maxCells});
+            while (!(cells() <= maxCells))
+                cellSize_ *= 2.0;
+        }
+        columns_ = static_cast<size_t>(floor(width / cellSize_)) + 1;
+        rows_ = static_cast<size_t>(floor(height / cellSize_)) + 1;
+
+        cellStart_.assign(columns_ * rows_ + 1, 0);
+        for (size_t i = 0; i < figures_.size(); ++i)
+            if (figures_[i])
+                forCells(boxes_[i], [&](size_t cell) { ++cellStart_[cell + 1]; });
+        for (size_t c = 1; c < cellStart_.size(); ++c)
+            cellStart_[c] += cellStart_[c - 1];
+        cellItems_.resize(cellStart_.back());
+        vector<size_t> fill(cellStart_.begin(), cellStart_.end() - 1);
+        for (size_t i = 0; i < figures_.size(); ++i)
+            if (figures_[i])
+                forCells(boxes_[i], [&](size_t cell) { cellItems_[fill[cell]++] = i; });
+    }
+
+    double getCellSize() const { return cellSize_; }
+    size_t getCellCount() const { return columns_ * rows_; }
+
+    vector<size_t> queryBox(const BoundingBox<T>& box) const {
+        vector<size_t> result;
+        if (columns_ == 0) return result;
+        forCells(box, [&](size_t cell) {
+            for (size_t k = cellStart_[cell]; k < cellStart_[cell + 1]; ++k)
+                if (boxes_[cellItems_[k]].intersects(box))
+                    result.push_back(cellItems_[k]);
+        });
+        sort(result.begin(), result.end());
+        result.erase(unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+    vector<size_t> queryPoint(const Point<T>& p) const {
+        vector<size_t> result;
+        for (size_t index : queryBox(BoundingBox<T>{p, p})) {
+            const Figure<T>* figure = figures_[index];
+            if (pointInPolygon(figure->getPoints(), figure->getSize(), p))
+                result.push_back(index);
+        }
+        return result;
+    }
+};
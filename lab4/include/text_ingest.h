@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "array.h"
+#include "figure.h"
+#include "pentagon.h"
+#include "point.h"
+#include "rhombus.h"
+#include "trapezoid.h"
+
+using namespace std;
+
+// Построчный формат без приглашений к вводу:
+//   R x1 y1 x2 y2 x3 y3 x4 y4
+//   T x1 y1 x2 y2 x3 y3 x4 y4
+//   P x1 y1 x2 y2 x3 y3 x4 y4 x5 y5
+// Пустые строки и строки, начинающиеся с '#', пропускаются.
+struct IngestError {
+    size_t line;
+    string message;
+};
+
+struct IngestResult {
+    size_t figures = 0;
+    size_t lines = 0;
+    size_t bytes = 0;
+    vector<IngestError> errors;
+};
+
+template <Scalar T>
+class TextIngest {
+private:
+    Array<T>& array_;
+    size_t batchSize_;
+    vector<shared_ptr<Figure<T>>> batch_;
+    IngestResult result_;
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    static const char* skipSpaces(const char* p, const char* end) {
+        while (p < end && isSpace(*p)) ++p;
+        return p;
+    }
+
+    // Пакет целиком: Array растёт не больше одного раза на пакет.
+    void flush() {
+        array_.addFigures(move(batch_));
+        batch_.clear();
+    }
+
+    void fail(const char* message) {
+        result_.errors.push_back({result_.lines, message});
+    }
+
+    void parseLine(const char* p, const char* end) {
+        p = skipSpaces(p, end);
+        if (p == end || *p == '#') return;
+
+        size_t arity;
+        const char tag = *p++;
+        switch (tag) {
+            case 'R': case 'T': arity = 4; break;
+            case 'P': arity = 5; break;
+            default:
+                fail("неизвестный тип фигуры");
+                return;
+        }
+        if (p < end && !isSpace(*p)) {
+            fail("неизвестный тип фигуры");
+            return;
+        }
+
+        array<Point<T>, 5> points;
+        for (size_t i = 0; i < arity; ++i) {
+            for (T* value : {&points[i].x, &points[i].y}) {
+                p = skipSpaces(p, end);
+                auto [next, ec] = from_chars(p, end, *value);
+                if (ec != errc() || (next < end && !isSpace(*next))) {
+                    fail(p == end ? "недостаточно координат" : "неверное число");
+                    return;
+                }
+                p = next;
+            }
+        }
+        if (skipSpaces(p, end) != end) {
+            fail("лишние данные в конце строки");
+            return;
+        }
+
+        switch (tag) {
+            case 'R':
+                batch_.push_back(make_shared<Rhombus<T>>(points[0], points[1], points[2], points[3]));
+                break;
+            case 'T':
+                batch_.push_back(make_shared<Trapezoid<T>>(points[0], points[1], points[2], points[3]));
+                break;
+            default:
+                batch_.push_back(make_shared<Pentagon<T>>(points[0], points[1], points[2], points[3], points[4]));
+                break;
+        }
+        ++result_.figures;
+        if (batch_.size() >= batchSize_)
+            flush();
+    }
+
+public:
+    TextIngest(Array<T>& array, size_t batchSize = 4096)
+        : array_(array), batchSize_(batchSize ? batchSize : 1) {
+        batch_.reserve(batchSize_);
+    }
+
+    // Разбирает весь поток кусками по chunkSize байт; ошибки не прерывают разбор.
+    IngestResult run(istream& is, size_t chunkSize = 1 << 20) {
+        string buffer(max<size_t>(chunkSize, 64), '\0');
+        size_t carry = 0;
+        while (true) {
+            if (carry == buffer.size())
+                buffer.resize(buffer.size() * 2);
+            is.read(buffer.data() + carry, static_cast<streamsize>(buffer.size() - carry));
+            const size_t got = static_cast<size_t>(is.gcount());
+            result_.bytes += got;
+            LAB4_COUNT(BytesParsed, got);
+            const size_t filled = carry + got;
+            const bool eof = got == 0 || !is;
+
+            const char* begin = buffer.data();
+            const char* end = begin + filled;
+            const char* line = begin;
+            for (const char* nl; (nl = static_cast<const char*>(memchr(line, '\n', end - line))); line = nl + 1) {
+                ++result_.lines;
+                parseLine(line, nl);
+            }
+            carry = static_cast<size_t>(end - line);
+            if (eof) {
+                if (carry > 0) {
+                    ++result_.lines;
+                    parseLine(line, end);
+                }
+                break;
+            }
+            memmove(buffer.data(), line, carry);
+        }
+        flush();
+        return move(result_);
+    }
+};
+
+template <Scalar T>
+IngestResult ingestText(istream& is, Array<T>& array, size_t batchSize = 4096) {
+    return TextIngest<T>(array, batchSize).run(is);
+}
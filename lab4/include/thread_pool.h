@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class ThreadPool {
+private:
+    struct Queue {
+        mutex m;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<Queue>> queues_;
+    vector<thread> workers_;
+    atomic<uint32_t> signal_{0};
+    atomic<size_t> pending_{0};
+    atomic<size_t> next_{0};
+    atomic<bool> stop_{false};
+
+    bool popFrom(Queue& q, bool back, function<void()>& task) {
+        lock_guard<mutex> lock(q.m);
+        if (q.tasks.empty()) return false;
+        if (back) {
+            task = move(q.tasks.back());
+            q.tasks.pop_back();
+        } else {
+            task = move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        return true;
+    }
+
+    bool tryRun(size_t self) {
+        function<void()> task;
+        const size_t n = queues_.size();
+        bool found = popFrom(*queues_[self], true, task);
+        for (size_t i = 1; !found && i < n; ++i)
+            found = popFrom(*queues_[(self + i) % n], false, task);
+        if (!found) return false;
+        pending_.fetch_sub(1, memory_order_relaxed);
+        task();
+        return true;
+    }
+
+    void push(function<void()> task) {
+        const size_t q = next_.fetch_add(1, memory_order_relaxed) % queues_.size();
+        pending_.fetch_add(1, memory_order_relaxed);
+        {
+            lock_guard<mutex> lock(queues_[q]->m);
+            queues_[q]->tasks.push_back(move(task));
+        }
+        signal_.fetch_add(1, memory_order_release);
+        signal_.notify_one();
+    }
+
+    void workerLoop(size_t self) {
+        while (true) {
+            if (tryRun(self)) continue;
+            const uint32_t seen = signal_.load(memory_order_acquire);
+            if (pending_.load(memory_order_relaxed) > 0) continue;
+            if (stop_.load(memory_order_acquire)) return;
+            signal_.wait(seen, memory_order_acquire);
+        }
+    }
+
+public:
+    explicit ThreadPool(size_t threads = max<size_t>(1, thread::hardware_concurrency())) {
+        const size_t n = max<size_t>(1, threads);
+        for (size_t i = 0; i < n; ++i)
+            queues_.push_back(make_unique<Queue>());
+        for (size_t i = 0; i < n; ++i)
+            workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~ThreadPool() {
+        stop_.store(true, memory_order_release);
+        signal_.fetch_add(1, memory_order_release);
+        signal_.notify_all();
+        for (auto& worker : workers_)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t getThreadCount() const { return workers_.size(); }
+
+    // body(begin, end) вызывается для каждого куска [begin, end) длиной не больше grain.
+    // Вызывающий поток тоже выполняет задачи, пока ждёт, поэтому вложенные вызовы не блокируются.
+    // Если body бросает исключение, оставшиеся куски пропускаются, а первое исключение
+    // перебрасывается вызывающему после завершения всех задач.
+    void parallelFor(size_t count, size_t grain, const function<void(size_t, size_t)>& body) {
+        if (count == 0) return;
+        grain = max<size_t>(1, grain);
+        const size_t chunks = (count + grain - 1) / grain;
+        if (chunks == 1) {
+            body(0, count);
+            return;
+        }
+        atomic<size_t> remaining{chunks};
+        atomic<bool> failed{false};
+        exception_ptr error;
+        for (size_t c = 0; c < chunks; ++c) {
+            const size_t begin = c * grain;
+            const size_t end = min(count, begin + grain);
+            push([&body, &remaining, &failed, &error, begin, end] {
+                try {
+                    if (!failed.load(memory_order_relaxed))
+                        body(begin, end);
+                } catch (...) {
+                    if (!failed.exchange(true, memory_order_relaxed))
+                        error = current_exception();
+                }
+                remaining.fetch_sub(1, memory_order_acq_rel);
+            });
+        }
+        const size_t self = next_.load(memory_order_relaxed) % queues_.size();
+        while (remaining.load(memory_order_acquire) > 0) {
+            if (!tryRun(self))
+                this_thread::yield();
+        }
+        if (error)
+            rethrow_exception(error);
+    }
+
+    static ThreadPool& instance() {
+        static ThreadPool pool;
+        return pool;
+    }
+};
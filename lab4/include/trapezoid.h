@@ -31,67 +31,29 @@ optional<pair<Point<T>, double>> circumcircle(const Point<T>& A, const Point<T>&
 }
 
 template <Scalar T>
-class Trapezoid : public Figure<T> {
-public:
-    Trapezoid() {
-        this->size_ = 4;
-        this->points_ = make_unique<Point<T>[]>(4);
+class Trapezoid final : public FixedFigure<T, 4> {
+protected:
+    constexpr double computeArea() const override {
+        return this->shoelaceArea();
     }
 
-    Trapezoid(const Point<T>& p1, const Point<T>& p2,
-        const Point<T>& p3, const Point<T>& p4) {
-
-        this->size_ = 4;
-        this->points_ = make_unique<Point<T>[]>(4);
-
-        this->points_[0] = p1;
-        this->points_[1] = p2;
-        this->points_[2] = p3;
-        this->points_[3] = p4;
-    }
-
-
-    Trapezoid(const Trapezoid& other) {
-        this->size_ = other.size_;
-        this->points_ = make_unique<Point<T>[]>(this->size_);
-        for (size_t i = 0; i < this->size_; ++i) {
-            this->points_[i] = other.points_[i];
-        }
-    }
+public:
+    constexpr Trapezoid() = default;
 
-    Trapezoid& operator=(const Trapezoid& other) {
-        if (this == &other) return *this;
-        this->size_ = other.size_;
-        this->points_ = make_unique<Point<T>[]>(this->size_);
-        for (size_t i = 0; i < this->size_; ++i) {
-            this->points_[i] = other.points_[i];
-        }
-        return *this;
-    }
+    constexpr Trapezoid(const Point<T>& p1, const Point<T>& p2,
+        const Point<T>& p3, const Point<T>& p4)
+        : FixedFigure<T, 4>({p1, p2, p3, p4}) {}
 
-    Trapezoid(Trapezoid&& other) noexcept {
-        this->size_ = other.size_;
-        this->points_ = move(other.points_);
-        other.size_ = 0;
-    }
+    Trapezoid(const Trapezoid& other) = default;
+    Trapezoid& operator=(const Trapezoid& other) = default;
+    Trapezoid(Trapezoid&& other) noexcept = default;
+    Trapezoid& operator=(Trapezoid&& other) noexcept = default;
 
-    Trapezoid& operator=(Trapezoid&& other) noexcept {
-        if (this == &other) return *this;
-        this->size_ = other.size_;
-        this->points_ = move(other.points_);
-        other.size_ = 0;
-        return *this;
-    }
-
-    ~Trapezoid() = default;
+    constexpr ~Trapezoid() = default;
 
     void read(istream& is) override {
         cout << "Введите 4 точки трапеции (x y): " << endl;
-        this->size_ = 4;
-        this->points_ = make_unique<Point<T>[]>(4);
-        for (size_t i = 0; i < this->size_; ++i) {
-            is >> this->points_[i];
-        }
+        this->readPoints(is);
 
         auto circ = circumcircle(this->points_[0], this->points_[1], this->points_[2]);
         if (!circ.has_value()) {
@@ -107,49 +69,28 @@ public:
 
     void print(ostream& os) const override {
         os << "Трапеция: ";
-        for (size_t i = 0; i < this->size_; ++i) {
-            os << this->points_[i] << " ";
-        }
-    }
-
-    Point<T> getCenter() const override {
-        T cx = 0, cy = 0;
-        for (size_t i = 0; i < this->size_; ++i) {
-            cx += this->points_[i].x;
-            cy += this->points_[i].y;
-        }
-        return Point<T>(cx / this->size_, cy / this->size_);
+        this->printPoints(os);
     }
 
-    double getArea() const override {
-        double area = 0.0;
-        for (size_t i = 0; i < this->size_; ++i) {
-            Point<T>& p1 = this->points_[i];
-            Point<T>& p2 = this->points_[(i + 1) % this->size_]; 
-            area += (static_cast<double>(p1.x) * static_cast<double>(p2.y) - 
-                     static_cast<double>(p2.x) * static_cast<double>(p1.y));
-        }
-        return abs(area) / 2.0;
-    }
-
-    operator double() const override {
-        return getArea();
+    constexpr operator double() const override {
+        return this->getArea();
     }
 
     unique_ptr<Figure<T>> clone() const override {
+        LAB4_COUNT(Clones, 1);
+        LAB4_TIME(Clone);
         return make_unique<Trapezoid<T>>(*this);
     }
 
-    bool operator==(const Figure<T>& other) const override {
+    constexpr bool operator==(const Figure<T>& other) const override {
         const Trapezoid<T>* trapezoid = dynamic_cast<const Trapezoid<T>*>(&other);
         if (!trapezoid) {
             return false;
         }
-        for (size_t i = 0; i < this->size_; ++i) {
-            if (!(this->points_[i] == trapezoid->points_[i])) {
-                return false;
-            }
-        }
-        return true;
+        return this->samePoints(*trapezoid);
+    }
+
+    constexpr FigureKind kind() const override {
+        return FigureKind::Trapezoid;
     }
 };
\ No newline at end of file
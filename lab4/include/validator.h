@@ -0,0 +1,280 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "array.h"
+#include "figure.h"
+#include "figure_store.h"
+#include "thread_pool.h"
+
+using namespace std;
+
+enum ValidationFlag : uint8_t {
+    VALID = 0,
+    DEGENERATE = 1,
+    UNEQUAL_SIDES = 2,
+    NOT_TRAPEZOID = 4,
+    NOT_CYCLIC = 8,
+    NOT_CONVEX = 16,
+    NOT_SIMPLE = 32,
+    // Пустая ячейка Array: не ошибка, errors() её пропускает.
+    EMPTY = 64
+};
+
+struct ValidationError {
+    size_t index;
+    uint8_t flags;
+};
+
+namespace validator_detail {
+
+inline constexpr size_t BLOCK = 64;
+
+// min/max по значению: выбор без ссылок векторизуется как blend.
+inline double lesser(double a, double b) {
+    return b < a ? b : a;
+}
+
+inline double greater(double a, double b) {
+    return a < b ? b : a;
+}
+
+// Флаги копятся в double (биты не пересекаются, поэтому сумма — это OR),
+// чтобы основной цикл не смешивал ширины; сужение до байта — отдельным проходом.
+inline double flag(bool condition, ValidationFlag value) {
+    return condition ? static_cast<double>(value) : 0.0;
+}
+
+inline void pack(const double* mask, uint8_t* flags) {
+    for (size_t i = 0; i < BLOCK; ++i)
+        flags[i] = static_cast<uint8_t>(mask[i]);
+}
+
+// Координаты BLOCK фигур в double: x[k][i] — k-я вершина i-й фигуры блока,
+// отсчитанная от её первой вершины, чтобы проверки не зависели от положения фигуры.
+// Хвост неполного блока заполняется нулями, поэтому все циклы ниже имеют
+// постоянное число итераций и идут по i при фиксированной вершине.
+template <size_t N>
+struct Lanes {
+    alignas(32) double x[N][BLOCK];
+    alignas(32) double y[N][BLOCK];
+
+    template <Scalar T>
+    void load(const CoordBlock<T, N>& b, size_t first, size_t count) {
+        const T* ox = b.x[0].data() + first;
+        const T* oy = b.y[0].data() + first;
+        for (size_t k = 0; k < N; ++k) {
+            const T* xs = b.x[k].data() + first;
+            const T* ys = b.y[k].data() + first;
+            for (size_t i = 0; i < count; ++i) {
+                x[k][i] = static_cast<double>(xs[i]) - static_cast<double>(ox[i]);
+                y[k][i] = static_cast<double>(ys[i]) - static_cast<double>(oy[i]);
+            }
+            for (size_t i = count; i < BLOCK; ++i) {
+                x[k][i] = 0.0;
+                y[k][i] = 0.0;
+            }
+        }
+    }
+};
+
+// Квадрат размера фигуры (большей стороны её ограничивающего прямоугольника) —
+// масштаб относительных допусков.
+template <size_t N>
+void scale2(const Lanes<N>& l, double* out) {
+    double lx[BLOCK], hx[BLOCK], ly[BLOCK], hy[BLOCK];
+    for (size_t i = 0; i < BLOCK; ++i) {
+        lx[i] = hx[i] = l.x[0][i];
+        ly[i] = hy[i] = l.y[0][i];
+    }
+    for (size_t k = 1; k < N; ++k) {
+        for (size_t i = 0; i < BLOCK; ++i) {
+            lx[i] = lesser(lx[i], l.x[k][i]);
+            hx[i] = greater(hx[i], l.x[k][i]);
+            ly[i] = lesser(ly[i], l.y[k][i]);
+            hy[i] = greater(hy[i], l.y[k][i]);
+        }
+    }
+    for (size_t i = 0; i < BLOCK; ++i) {
+        const double extent = greater(hx[i] - lx[i], hy[i] - ly[i]);
+        out[i] = extent * extent;
+    }
+}
+
+template <size_t N>
+void doubledArea(const Lanes<N>& l, double* out) {
+    for (size_t i = 0; i < BLOCK; ++i)
+        out[i] = 0.0;
+    for (size_t k = 0; k < N; ++k) {
+        const size_t n = k + 1 == N ? 0 : k + 1;
+        for (size_t i = 0; i < BLOCK; ++i)
+            out[i] += l.x[k][i] * l.y[n][i] - l.x[n][i] * l.y[k][i];
+    }
+}
+
+inline void checkRhombi(const Lanes<4>& l, double eps, uint8_t* flags) {
+    double tol[BLOCK], area[BLOCK], lo[BLOCK], hi[BLOCK];
+    scale2(l, tol);
+    doubledArea(l, area);
+    for (size_t i = 0; i < BLOCK; ++i) {
+        tol[i] *= eps;
+        lo[i] = INFINITY;
+        hi[i] = -INFINITY;
+    }
+    for (size_t k = 0; k < 4; ++k) {
+        const size_t n = (k + 1) % 4;
+        for (size_t i = 0; i < BLOCK; ++i) {
+            const double dx = l.x[n][i] - l.x[k][i], dy = l.y[n][i] - l.y[k][i];
+            const double side = dx * dx + dy * dy;
+            lo[i] = lesser(lo[i], side);
+            hi[i] = greater(hi[i], side);
+        }
+    }
+    double mask[BLOCK];
+    for (size_t i = 0; i < BLOCK; ++i)
+        mask[i] = flag(abs(area[i]) <= tol[i], DEGENERATE) + flag(hi[i] - lo[i] > tol[i], UNEQUAL_SIDES);
+    pack(mask, flags);
+}
+
+inline void checkTrapezoids(const Lanes<4>& l, double eps, uint8_t* flags) {
+    double s2[BLOCK], area[BLOCK], mask[BLOCK];
+    scale2(l, s2);
+    doubledArea(l, area);
+    const double *x0 = l.x[0], *x1 = l.x[1], *x2 = l.x[2], *x3 = l.x[3];
+    const double *y0 = l.y[0], *y1 = l.y[1], *y2 = l.y[2], *y3 = l.y[3];
+    for (size_t i = 0; i < BLOCK; ++i) {
+        const double tol = eps * s2[i];
+        const double ax = x1[i] - x0[i], ay = y1[i] - y0[i];
+        const double bx = x2[i] - x0[i], by = y2[i] - y0[i];
+        const double cx = x3[i] - x0[i], cy = y3[i] - y0[i];
+        const double a2 = ax * ax + ay * ay, b2 = bx * bx + by * by, c2 = cx * cx + cy * cy;
+        // Определитель «точка в окружности» относительно первой вершины.
+        const double incircle = ax * (by * c2 - b2 * cy) - ay * (bx * c2 - b2 * cx) + a2 * (bx * cy - by * cx);
+        // Стороны 01 и 32, 12 и 03 — пары противолежащих сторон.
+        const double px = x2[i] - x3[i], py = y2[i] - y3[i];
+        const double qx = x2[i] - x1[i], qy = y2[i] - y1[i];
+        const bool parallel = (abs(ax * py - ay * px) <= tol) | (abs(qx * cy - qy * cx) <= tol);
+        mask[i] = flag(abs(area[i]) <= tol, DEGENERATE) + flag(!parallel, NOT_TRAPEZOID) +
+                  flag(abs(incircle) > tol * s2[i], NOT_CYCLIC);
+    }
+    pack(mask, flags);
+}
+
+inline void checkPentagons(const Lanes<5>& l, double eps, uint8_t* flags) {
+    double tol[BLOCK], area[BLOCK], positive[BLOCK], negative[BLOCK], crossed[BLOCK], mask[BLOCK];
+    scale2(l, tol);
+    doubledArea(l, area);
+    for (size_t i = 0; i < BLOCK; ++i) {
+        tol[i] *= eps;
+        positive[i] = negative[i] = crossed[i] = 0.0;
+    }
+    // Знак поворота в каждой вершине: выпуклый — все повороты в одну сторону.
+    for (size_t k = 0; k < 5; ++k) {
+        const size_t k1 = (k + 1) % 5, k2 = (k + 2) % 5;
+        for (size_t i = 0; i < BLOCK; ++i) {
+            const double ux = l.x[k1][i] - l.x[k][i], uy = l.y[k1][i] - l.y[k][i];
+            const double vx = l.x[k2][i] - l.x[k1][i], vy = l.y[k2][i] - l.y[k1][i];
+            const double c = ux * vy - uy * vx;
+            positive[i] += c > tol[i] ? 1.0 : 0.0;
+            negative[i] += c < -tol[i] ? 1.0 : 0.0;
+        }
+    }
+    // Несмежные пары рёбер пятиугольника: (0,2), (0,3), (1,3), (1,4), (2,4).
+    constexpr size_t pairs[5][2] = {{0, 2}, {0, 3}, {1, 3}, {1, 4}, {2, 4}};
+    for (const auto& p : pairs) {
+        const double *ax = l.x[p[0]], *ay = l.y[p[0]], *bx = l.x[(p[0] + 1) % 5], *by = l.y[(p[0] + 1) % 5];
+        const double *cx = l.x[p[1]], *cy = l.y[p[1]], *dx = l.x[(p[1] + 1) % 5], *dy = l.y[(p[1] + 1) % 5];
+        for (size_t i = 0; i < BLOCK; ++i) {
+            const double ex = dx[i] - cx[i], ey = dy[i] - cy[i];
+            const double fx = bx[i] - ax[i], fy = by[i] - ay[i];
+            const double d1 = ex * (ay[i] - cy[i]) - ey * (ax[i] - cx[i]);
+            const double d2 = ex * (by[i] - cy[i]) - ey * (bx[i] - cx[i]);
+            const double d3 = fx * (cy[i] - ay[i]) - fy * (cx[i] - ax[i]);
+            const double d4 = fx * (dy[i] - ay[i]) - fy * (dx[i] - ax[i]);
+            crossed[i] = (d1 * d2 < 0) & (d3 * d4 < 0) ? 1.0 : crossed[i];
+        }
+    }
+    for (size_t i = 0; i < BLOCK; ++i) {
+        const bool convex = (positive[i] == 5.0) | (negative[i] == 5.0);
+        mask[i] = flag(abs(area[i]) <= tol[i], DEGENERATE) + flag(!convex, NOT_CONVEX) +
+                  flag(!convex & (crossed[i] != 0.0), NOT_SIMPLE);
+    }
+    pack(mask, flags);
+}
+
+}
+
+// Проверки идут по упакованным координатам FigureStore блоками по BLOCK фигур:
+// внутренние циклы — по фигурам блока при фиксированной вершине, без ветвлений и
+// с постоянным числом итераций, поэтому GCC 12 векторизует их при -O3, в том числе
+// без -march (проверено -fopt-info-vec). Допуски относительные: eps умножается
+// на квадрат (или четвёртую степень для вписанности) размера фигуры.
+template <Scalar T>
+class BatchValidator {
+private:
+    ThreadPool& pool_;
+    size_t grain_;
+    double eps_;
+
+    template <size_t N, typename Check>
+    void checkBlocks(const CoordBlock<T, N>& b, uint8_t* out, Check check) const {
+        using validator_detail::BLOCK;
+        pool_.parallelFor(b.size(), grain_, [&](size_t begin, size_t end) {
+            validator_detail::Lanes<N> lanes;
+            uint8_t flags[BLOCK];
+            for (size_t first = begin; first < end; first += BLOCK) {
+                const size_t count = min(BLOCK, end - first);
+                lanes.load(b, first, count);
+                check(lanes, eps_, flags);
+                copy(flags, flags + count, out + first);
+            }
+        });
+    }
+
+public:
+    explicit BatchValidator(ThreadPool& pool = ThreadPool::instance(), size_t grain = 4096, double eps = 1e-9)
+        : pool_(pool), grain_(grain), eps_(eps) {}
+
+    // Маска ValidationFlag для каждой фигуры в порядке FigureStore; VALID — фигура корректна.
+    vector<uint8_t> validate(const FigureStore<T>& store) const {
+        vector<uint8_t> rhombi(store.rhombi().size());
+        vector<uint8_t> trapezoids(store.trapezoids().size());
+        vector<uint8_t> pentagons(store.pentagons().size());
+        checkBlocks(store.rhombi(), rhombi.data(), validator_detail::checkRhombi);
+        checkBlocks(store.trapezoids(), trapezoids.data(), validator_detail::checkTrapezoids);
+        checkBlocks(store.pentagons(), pentagons.data(), validator_detail::checkPentagons);
+
+        vector<uint8_t> flags(store.getSize());
+        for (size_t i = 0; i < flags.size(); ++i) {
+            switch (store.getKind(i)) {
+                case FigureKind::Rhombus:   flags[i] = rhombi[store.getSlot(i)]; break;
+                case FigureKind::Trapezoid: flags[i] = trapezoids[store.getSlot(i)]; break;
+                case FigureKind::Pentagon:  flags[i] = pentagons[store.getSlot(i)]; break;
+            }
+        }
+        return flags;
+    }
+
+    // По маске на каждую ячейку Array; пустые ячейки получают EMPTY.
+    vector<uint8_t> validate(const Array<T>& array) const {
+        const vector<uint8_t> packed = validate(FigureStore<T>(array));
+        vector<uint8_t> flags(array.getSize(), EMPTY);
+        size_t next = 0;
+        for (size_t i = 0; i < flags.size(); ++i)
+            if (array[i])
+                flags[i] = packed[next++];
+        return flags;
+    }
+
+    static vector<ValidationError> errors(const vector<uint8_t>& flags) {
+        vector<ValidationError> result;
+        for (size_t i = 0; i < flags.size(); ++i)
+            if (flags[i] != VALID && flags[i] != EMPTY)
+                result.push_back({i, flags[i]});
+        return result;
+    }
+};
@@ -1,12 +1,37 @@
 #include <gtest/gtest.h>
 #include <memory>
+#include <vector>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <sstream>
+#include <thread>
+#include <atomic>
 
 #include "array.h"
 #include "figure.h"
+#include "cached_figure.h"
 #include "point.h"
 #include "rhombus.h"
 #include "trapezoid.h"
 #include "pentagon.h"
+#include "figure_store.h"
+#include "area_kernel.h"
+#include "parallel.h"
+#include "arena.h"
+#include "scene_io.h"
+#include "text_ingest.h"
+#include "spatial_index.h"
+#include "figure_variant.h"
+#include "validator.h"
+#include "concurrent_array.h"
+#include "figure_format.h"
+#include "instrumentation.h"
+#include "affine.h"
+#include "collision.h"
+#include "dedup.h"
+#include "ordering.h"
+#include "segmented_array.h"
 
 using namespace std;
 
@@ -148,4 +173,1259 @@ TEST(ArrayTest, IndexOutOfBounds) {
 
     EXPECT_EQ(array.getFigure(10), nullptr); 
     EXPECT_EQ(array[10], nullptr);
-}
\ No newline at end of file
+}
+
+TEST(FigureStoreTest, AreasAndCentersMatchArray) {
+    Array<double> array;
+    array.addFigure(makeRhombus<double>());
+    array.addFigure(makePentagon<double>());
+    array.addFigure(makeTrapezoid<double>());
+
+    FigureStore<double> store(array);
+    EXPECT_EQ(store.getSize(), 3);
+    EXPECT_EQ(store.getKind(1), FigureKind::Pentagon);
+
+    auto areas = store.getAreas();
+    auto centers = store.getCenters();
+    for (size_t i = 0; i < array.getSize(); ++i) {
+        EXPECT_DOUBLE_EQ(areas[i], array[i]->getArea());
+        EXPECT_EQ(centers[i], array[i]->getCenter());
+    }
+    EXPECT_DOUBLE_EQ(store.getAllArea(), array.getAllArea());
+}
+
+TEST(FigureStoreTest, RoundTripToArray) {
+    Array<int> array;
+    array.addFigure(makeTrapezoid<int>());
+    array.addFigure(makeRhombus<int>());
+
+    Array<int> restored = FigureStore<int>(array).toArray();
+    ASSERT_EQ(restored.getSize(), 2);
+    EXPECT_TRUE(*restored[0] == *array[0]);
+    EXPECT_TRUE(*restored[1] == *array[1]);
+}
+
+template <Scalar T, size_t N>
+void checkAreaKernelLevels() {
+    const size_t count = 11;
+    vector<T> xs[N], ys[N];
+    const T* xp[N];
+    const T* yp[N];
+    for (size_t k = 0; k < N; ++k) {
+        for (size_t i = 0; i < count; ++i) {
+            xs[k].push_back(static_cast<T>((i * 7 + k * 3) % 13) - static_cast<T>(5));
+            ys[k].push_back(static_cast<T>((i * 5 + k * 11) % 17) - static_cast<T>(8));
+        }
+        xp[k] = xs[k].data();
+        yp[k] = ys[k].data();
+    }
+    vector<double> scalar(count), sse(count), avx(count);
+    batchShoelaceArea<T, N>(xp, yp, count, scalar.data(), SimdLevel::Scalar);
+    batchShoelaceArea<T, N>(xp, yp, count, sse.data(), SimdLevel::SSE2);
+    batchShoelaceArea<T, N>(xp, yp, count, avx.data(), SimdLevel::AVX2);
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(scalar[i], sse[i]);
+        EXPECT_EQ(scalar[i], avx[i]);
+    }
+}
+
+TEST(AreaKernelTest, SimdLevelsMatchScalar) {
+    checkAreaKernelLevels<int, 4>();
+    checkAreaKernelLevels<int, 5>();
+    checkAreaKernelLevels<float, 4>();
+    checkAreaKernelLevels<float, 5>();
+    checkAreaKernelLevels<double, 4>();
+    checkAreaKernelLevels<double, 5>();
+}
+
+TEST(AreaKernelTest, MatchesFigureArea) {
+    auto pentagon = makePentagon<double>();
+    const Point<double>* p = pentagon->getPoints();
+    double x[5][1], y[5][1];
+    const double* xp[5];
+    const double* yp[5];
+    for (size_t k = 0; k < 5; ++k) {
+        x[k][0] = p[k].x;
+        y[k][0] = p[k].y;
+        xp[k] = x[k];
+        yp[k] = y[k];
+    }
+    double area = 0.0;
+    batchShoelaceArea<double, 5>(xp, yp, 1, &area);
+    EXPECT_DOUBLE_EQ(area, pentagon->getArea());
+}
+
+template <Scalar T>
+Array<T> makeScene(size_t count) {
+    Array<T> array;
+    for (size_t i = 0; i < count; ++i) {
+        T s = static_cast<T>(i % 7 + 1);
+        switch (i % 3) {
+            case 0:
+                array.addFigure(make_shared<Rhombus<T>>(
+                    Point<T>(0, 0), Point<T>(s, 1), Point<T>(0, 2), Point<T>(-s, 1)));
+                break;
+            case 1:
+                array.addFigure(make_shared<Trapezoid<T>>(
+                    Point<T>(-s, 0), Point<T>(s, 0), Point<T>(1, s), Point<T>(-1, s)));
+                break;
+            default:
+                array.addFigure(make_shared<Pentagon<T>>(
+                    Point<T>(0, 0), Point<T>(s, 0), Point<T>(s, s), Point<T>(1, s + 1), Point<T>(0, s)));
+                break;
+        }
+    }
+    return array;
+}
+
+TEST(ParallelTest, AllAreaIsDeterministic) {
+    auto array = makeScene<double>(1000);
+    ThreadPool single(1);
+    ThreadPool many(4);
+
+    const auto* figures = array.begin();
+    double expected = pairwiseSum(0, array.getSize(), [figures](size_t i) {
+        return static_cast<double>(*figures[i]);
+    });
+    EXPECT_EQ(parallelAllArea(array, single, 16), expected);
+    EXPECT_EQ(parallelAllArea(array, many, 16), expected);
+    EXPECT_EQ(parallelAllArea(array, many, 333), expected);
+    EXPECT_NEAR(parallelAllArea(array, many, 64), array.getAllArea(), 1e-9);
+}
+
+TEST(ParallelTest, CentroidAndHistogram) {
+    Array<double> array;
+    array.addFigure(makeRhombus<double>());
+    array.addFigure(makePentagon<double>());
+    array.addFigure(makeTrapezoid<double>());
+    ThreadPool pool(2);
+
+    auto centroid = parallelCentroid(array, pool, 1);
+    double cx = 0, cy = 0;
+    for (const auto& figure : array) {
+        cx += figure->getCenter().x;
+        cy += figure->getCenter().y;
+    }
+    EXPECT_DOUBLE_EQ(centroid.x, cx / 3);
+    EXPECT_DOUBLE_EQ(centroid.y, cy / 3);
+
+    auto histogram = parallelAreaHistogram(array, 3, 4.0, 7.0, pool, 1);
+    ASSERT_EQ(histogram.size(), 3);
+    EXPECT_EQ(histogram[0], 1);
+    EXPECT_EQ(histogram[1], 1);
+    EXPECT_EQ(histogram[2], 1);
+}
+
+TEST(ParallelTest, BodyExceptionsReachCaller) {
+    ThreadPool pool(3);
+    EXPECT_THROW(pool.parallelFor(1000, 10, [](size_t begin, size_t) {
+        if (begin == 500) throw runtime_error("кусок 50");
+    }), runtime_error);
+
+    atomic<size_t> total{0};
+    pool.parallelFor(1000, 10, [&total](size_t begin, size_t end) { total += end - begin; });
+    EXPECT_EQ(total.load(), 1000u);
+}
+
+TEST(ArenaTest, FiguresLiveInArena) {
+    FigureArena<double> arena(512);
+    Array<double> array;
+    for (int i = 0; i < 20; ++i) {
+        array.addFigure(arena.make<Rhombus<double>>(
+            Point<double>(0, 0), Point<double>(2, 1), Point<double>(0, 2), Point<double>(-2, 1)));
+        array.addFigure(arena.make<Pentagon<double>>(
+            Point<double>(0, 0), Point<double>(2, 0), Point<double>(2, 2), Point<double>(1, 3), Point<double>(0, 2)));
+    }
+    EXPECT_EQ(arena.getFigureCount(), 40);
+    EXPECT_GT(arena.getSlabCount(), 1);
+    EXPECT_EQ(array.begin()->use_count(), 1);
+    EXPECT_EQ(arena.getLiveCount(), 40);
+    EXPECT_DOUBLE_EQ(array.getAllArea(), 20 * (4.0 + 5.0));
+    EXPECT_THROW(arena.release(), runtime_error);
+
+    array = Array<double>();
+    EXPECT_EQ(arena.getLiveCount(), 0);
+    arena.release();
+    EXPECT_EQ(arena.getFigureCount(), 0);
+    EXPECT_EQ(arena.getSlabCount(), 1);
+
+    auto trapezoid = arena.make<Trapezoid<double>>(
+        Point<double>(-2, 0), Point<double>(2, 0), Point<double>(1, 2), Point<double>(-1, 2));
+    EXPECT_DOUBLE_EQ(trapezoid->getArea(), 6.0);
+
+    // Арена, уничтоженная раньше своих фигур, не оставляет висячих указателей.
+    testing::FLAGS_gtest_death_test_style = "threadsafe";
+    EXPECT_DEATH({
+        shared_ptr<Figure<double>> outlives;
+        {
+            FigureArena<double> scoped;
+            outlives = scoped.make<Rhombus<double>>(
+                Point<double>(0, 0), Point<double>(2, 1), Point<double>(0, 2), Point<double>(-2, 1));
+        }
+    }, "");
+}
+
+TEST(FixedFigureTest, InlineStorage) {
+    Pentagon<int> pentagon(Point<int>(0, 0), Point<int>(2, 0), Point<int>(2, 2), Point<int>(1, 3), Point<int>(0, 2));
+    EXPECT_EQ(pentagon.getSize(), 5);
+    EXPECT_EQ(Pentagon<int>::arity, 5);
+    EXPECT_LE(sizeof(Pentagon<int>), sizeof(void*) + 5 * sizeof(Point<int>) + sizeof(void*));
+
+    Pentagon<int> copy = pentagon;
+    EXPECT_NE(copy.getPoints(), pentagon.getPoints());
+    EXPECT_TRUE(copy == pentagon);
+    EXPECT_DOUBLE_EQ(copy.getArea(), pentagon.polygonArea());
+
+    auto clone = makeTrapezoid<double>()->clone();
+    EXPECT_DOUBLE_EQ(clone->getArea(), clone->polygonArea());
+    EXPECT_EQ(clone->getSize(), 4);
+}
+
+TEST(SceneIoTest, WriteAndMapScene) {
+    const string path = testing::TempDir() + "scene_io_test.bin";
+    auto array = makeScene<float>(50);
+    writeScene(array, path);
+
+    SceneFile<float> scene(path);
+    ASSERT_EQ(scene.getSize(), array.getSize());
+    for (size_t i = 0; i < scene.getSize(); ++i) {
+        auto view = scene[i];
+        EXPECT_EQ(view.kind, array[i]->kind());
+        EXPECT_EQ(view.arity, array[i]->getSize());
+        EXPECT_DOUBLE_EQ(view.getArea(), array[i]->getArea());
+        EXPECT_EQ(view.getCenter(), array[i]->getCenter());
+    }
+    Array<float> restored = scene.toArray();
+    EXPECT_TRUE(*restored[7] == *array[7]);
+
+    EXPECT_THROW(SceneFile<double> wrongType(path), runtime_error);
+    remove(path.c_str());
+}
+
+TEST(SceneIoTest, RejectsCorruptFile) {
+    const string path = testing::TempDir() + "scene_io_corrupt.bin";
+    {
+        ofstream out(path, ios::binary);
+        out << "definitely not a scene file, just some text";
+    }
+    EXPECT_THROW(SceneFile<double> scene(path), runtime_error);
+    EXPECT_THROW(SceneFile<double> missing(path + ".missing"), runtime_error);
+
+    // firstVertex + arity переполняется и указывает перед началом вершин.
+    writeScene(makeScene<double>(3), path);
+    {
+        fstream patch(path, ios::binary | ios::in | ios::out);
+        const uint64_t firstVertex = UINT64_MAX - 1;
+        patch.seekp(sizeof(SceneHeader));
+        patch.write(reinterpret_cast<const char*>(&firstVertex), sizeof(firstVertex));
+    }
+    EXPECT_THROW(SceneFile<double> overflow(path), runtime_error);
+    remove(path.c_str());
+}
+
+TEST(SceneIoTest, EmptySlotsKeepIndices) {
+    const string path = testing::TempDir() + "scene_io_empty.bin";
+    auto array = makeScene<double>(4);
+    array.removeFigure(1, RemovalPolicy::Tombstone);
+    writeScene(array, path);
+
+    SceneFile<double> scene(path);
+    ASSERT_EQ(scene.getSize(), 4);
+    EXPECT_TRUE(scene[1].empty());
+    EXPECT_DOUBLE_EQ(scene[1].getArea(), 0.0);
+    EXPECT_EQ(scene[2].kind, array[2]->kind());
+    EXPECT_DOUBLE_EQ(scene[3].getArea(), array[3]->getArea());
+    Array<double> restored = scene.toArray();
+    ASSERT_EQ(restored.getSize(), 4);
+    EXPECT_EQ(restored[1], nullptr);
+    EXPECT_TRUE(*restored[3] == *array[3]);
+    EXPECT_EQ(restored.getTombstoneCount(), array.getTombstoneCount());
+    EXPECT_EQ(restored.compact(), 1u);
+    EXPECT_EQ(restored.getSize(), 3);
+    remove(path.c_str());
+}
+
+TEST(TextIngestTest, ParsesFiguresAndReportsErrors) {
+    istringstream input(
+        "# scene\n"
+        "R 0 0 2 1 0 2 -2 1\n"
+        "\n"
+        "T -2 0 2 0 1 2 -1 2\n"
+        "P 0 0 2 0 2 2 1 3\n"
+        "X 1 2\n"
+        "R 0 0 2 1 0 2 -2 abc\n"
+        "P 0 0 2 0 2 2 1 3 0 2");
+    Array<double> array;
+    auto result = ingestText(input, array, 2);
+
+    EXPECT_EQ(result.figures, 3);
+    EXPECT_EQ(result.lines, 8);
+    ASSERT_EQ(array.getSize(), 3);
+    EXPECT_DOUBLE_EQ(array.getAllArea(), 15.0);
+    EXPECT_EQ(array[1]->kind(), FigureKind::Trapezoid);
+
+    ASSERT_EQ(result.errors.size(), 3);
+    EXPECT_EQ(result.errors[0].line, 5);
+    EXPECT_EQ(result.errors[1].line, 6);
+    EXPECT_EQ(result.errors[2].line, 7);
+}
+
+TEST(TextIngestTest, LinesSpanChunks) {
+    string text;
+    for (int i = 0; i < 100; ++i)
+        text += "R 0 0 2 1 0 2 -2 1\nP 0 0 2 0 2 2 1 3 0 2\n";
+    istringstream input(text);
+    Array<int> array;
+    auto result = TextIngest<int>(array).run(input, 7);
+
+    EXPECT_TRUE(result.errors.empty());
+    EXPECT_EQ(result.figures, 200);
+    EXPECT_EQ(result.bytes, text.size());
+    EXPECT_DOUBLE_EQ(array.getAllArea(), 100 * (4.0 + 5.0));
+    // Один пакет — одно расширение сразу до нужного размера.
+    EXPECT_EQ(array.getCapacity(), 200);
+}
+
+Array<double> makeGrid(int side) {
+    Array<double> array;
+    for (int i = 0; i < side; ++i)
+        for (int j = 0; j < side; ++j) {
+            double x = i * 3.0, y = j * 3.0;
+            if ((i + j) % 2)
+                array.addFigure(make_shared<Rhombus<double>>(
+                    Point<double>(x, y), Point<double>(x + 1, y + 1), Point<double>(x, y + 2), Point<double>(x - 1, y + 1)));
+            else
+                array.addFigure(make_shared<Pentagon<double>>(
+                    Point<double>(x, y), Point<double>(x + 2, y), Point<double>(x + 2, y + 2),
+                    Point<double>(x + 1, y + 3), Point<double>(x, y + 2)));
+        }
+    return array;
+}
+
+TEST(SpatialIndexTest, BoxAndPointQueriesMatchLinearScan) {
+    auto array = makeGrid(20);
+    RTree<double> tree(array, 4);
+    UniformGrid<double> grid(array, 5.0);
+    EXPECT_EQ(tree.getSize(), array.getSize());
+
+    BoundingBox<double> box{Point<double>(10, 10), Point<double>(25, 18)};
+    vector<size_t> expected;
+    for (size_t i = 0; i < array.getSize(); ++i)
+        if (array[i]->getBoundingBox().intersects(box))
+            expected.push_back(i);
+    EXPECT_EQ(tree.queryBox(box), expected);
+    EXPECT_EQ(grid.queryBox(box), expected);
+
+    Point<double> inside(31.0, 1.0);
+    auto hits = tree.queryPoint(inside);
+    ASSERT_EQ(hits.size(), 1);
+    EXPECT_EQ(hits[0], 10 * 20);
+    EXPECT_EQ(grid.queryPoint(inside), hits);
+    EXPECT_TRUE(tree.queryPoint(Point<double>(2.5, 2.5)).empty());
+
+    // Слишком мелкая ячейка для большого мира укрупняется до O(n) ячеек.
+    Array<double> far;
+    far.addFigure(makeRhombus<double>());
+    far.addFigure(make_shared<Rhombus<double>>(
+        Point<double>(1e9, 1e9), Point<double>(1e9 + 2, 1e9 + 1), Point<double>(1e9, 1e9 + 2), Point<double>(1e9 - 2, 1e9 + 1)));
+    UniformGrid<double> sparse(far, 1e-3);
+    EXPECT_LE(sparse.getCellCount(), 8);
+    EXPECT_EQ(sparse.queryPoint(Point<double>(1e9, 1e9 + 1)), vector<size_t>{1});
+    EXPECT_EQ(sparse.queryPoint(Point<double>(0, 1)), vector<size_t>{0});
+}
+
+TEST(SpatialIndexTest, NearestNeighbours) {
+    auto array = makeGrid(10);
+    RTree<double> tree(array, 4);
+    Point<double> query(13.2, 7.9);
+
+    vector<pair<double, size_t>> byCenter;
+    for (size_t i = 0; i < array.getSize(); ++i) {
+        auto c = array[i]->getCenter();
+        byCenter.push_back({(c.x - query.x) * (c.x - query.x) + (c.y - query.y) * (c.y - query.y), i});
+    }
+    sort(byCenter.begin(), byCenter.end());
+    auto nearest = tree.nearest(query, 5);
+    ASSERT_EQ(nearest.size(), 5);
+    for (size_t i = 0; i < 5; ++i)
+        EXPECT_EQ(nearest[i], byCenter[i].second);
+
+    auto containing = tree.nearest(Point<double>(3.0, 1.0), 1, NearestBy::Polygon);
+    ASSERT_EQ(containing.size(), 1);
+    EXPECT_EQ(containing[0], 10);
+    auto polygon = tree.nearest(Point<double>(1.0, 1.0), 1, NearestBy::Polygon);
+    ASSERT_EQ(polygon.size(), 1);
+    EXPECT_EQ(polygon[0], 0);
+}
+
+TEST(ArrayTest, RemovalPolicies) {
+    Array<int> array;
+    auto rhombus = makeRhombus<int>();
+    auto pentagon = makePentagon<int>();
+    auto trapezoid = makeTrapezoid<int>();
+    array.addFigure(rhombus);
+    array.addFigure(pentagon);
+    array.addFigure(trapezoid);
+
+    array.removeFigure(0, RemovalPolicy::Unordered);
+    ASSERT_EQ(array.getSize(), 2);
+    EXPECT_EQ(array[0], trapezoid);
+    EXPECT_EQ(array[1], pentagon);
+
+    array.addFigure(rhombus);
+    array.removeFigure(1, RemovalPolicy::Tombstone);
+    EXPECT_EQ(array.getSize(), 3);
+    EXPECT_EQ(array.getTombstoneCount(), 1);
+    EXPECT_EQ(array[1], nullptr);
+    EXPECT_EQ(array[2], rhombus);
+    EXPECT_DOUBLE_EQ(array.getAllArea(), 6.0 + 4.0);
+
+    EXPECT_EQ(array.compact(), 1);
+    EXPECT_EQ(array.getTombstoneCount(), 0);
+    ASSERT_EQ(array.getSize(), 2);
+    EXPECT_EQ(array[0], trapezoid);
+    EXPECT_EQ(array[1], rhombus);
+}
+
+TEST(ArrayTest, RemoveIf) {
+    auto array = makeScene<int>(30);
+    size_t removed = array.removeIf([](const Figure<int>& f) { return f.kind() == FigureKind::Pentagon; });
+    EXPECT_EQ(removed, 10);
+    ASSERT_EQ(array.getSize(), 20);
+    for (size_t i = 0; i < array.getSize(); ++i)
+        EXPECT_EQ(array[i]->kind(), i % 2 ? FigureKind::Trapezoid : FigureKind::Rhombus);
+}
+
+TEST(VariantArrayTest, MatchesArrayAndRoundTrips) {
+    auto array = makeScene<double>(30);
+    VariantArray<double> values(array);
+    ASSERT_EQ(values.getSize(), array.getSize());
+    EXPECT_DOUBLE_EQ(values.getAllArea(), array.getAllArea());
+
+    auto areas = values.getAreas();
+    auto centers = values.getCenters();
+    for (size_t i = 0; i < array.getSize(); ++i) {
+        EXPECT_DOUBLE_EQ(areas[i], array[i]->getArea());
+        EXPECT_EQ(centers[i], array[i]->getCenter());
+    }
+
+    Array<double> restored = values.toArray();
+    for (size_t i = 0; i < array.getSize(); ++i)
+        EXPECT_TRUE(*restored[i] == *array[i]);
+
+    EXPECT_TRUE(sameFigure(values[3], values[3]));
+    EXPECT_FALSE(sameFigure(values[3], values[4]));
+    EXPECT_FALSE(sameFigure(values[0], values[3]));
+
+    size_t pentagons = 0;
+    values.forEach([&pentagons](const auto& f) {
+        if constexpr (is_same_v<decay_t<decltype(f)>, Pentagon<double>>) ++pentagons;
+    });
+    EXPECT_EQ(pentagons, 10);
+}
+
+TEST(FigureCacheTest, InvalidatedOnMutation) {
+    CachedFigure<double, Rhombus> rhombus(Point<double>(0, 0), Point<double>(2, 1), Point<double>(0, 2), Point<double>(-2, 1));
+    EXPECT_DOUBLE_EQ(rhombus.getArea(), 4.0);
+    EXPECT_EQ(rhombus.getCenter(), Point<double>(0, 1));
+    auto box = rhombus.getBoundingBox();
+    EXPECT_EQ(box.lo, Point<double>(-2, 0));
+    EXPECT_EQ(box.hi, Point<double>(2, 2));
+
+    rhombus.setPoints({Point<double>(0, 0), Point<double>(4, 2), Point<double>(0, 4), Point<double>(-4, 2)});
+    EXPECT_DOUBLE_EQ(rhombus.getArea(), 16.0);
+    EXPECT_EQ(rhombus.getCenter(), Point<double>(0, 2));
+    EXPECT_EQ(rhombus.getBoundingBox().hi, Point<double>(4, 4));
+
+    rhombus.setPoint(2, Point<double>(0, 6));
+    EXPECT_EQ(rhombus.getBoundingBox().hi, Point<double>(4, 6));
+
+    istringstream input("0 0 2 1 0 2 -2 1");
+    input >> rhombus;
+    EXPECT_DOUBLE_EQ(rhombus.getArea(), 4.0);
+    EXPECT_EQ(rhombus.getCenter(), Point<double>(0, 1));
+
+    CachedFigure<double, Rhombus> other(Point<double>(0, 0), Point<double>(1, 1), Point<double>(0, 2), Point<double>(-1, 1));
+    EXPECT_DOUBLE_EQ(other.getArea(), 2.0);
+    other = rhombus;
+    EXPECT_DOUBLE_EQ(other.getArea(), 4.0);
+    EXPECT_EQ(other.getCenter(), Point<double>(0, 1));
+    EXPECT_TRUE(other == rhombus);
+    EXPECT_TRUE(other == static_cast<const Figure<double>&>(rhombus.shape()));
+    EXPECT_EQ(other.kind(), FigureKind::Rhombus);
+}
+
+TEST(FigureCacheTest, ConcurrentFirstReads) {
+    for (int round = 0; round < 20; ++round) {
+        auto pentagon = make_shared<CachedFigure<double, Pentagon>>(*makePentagon<double>());
+        vector<thread> threads;
+        for (int t = 0; t < 4; ++t)
+            threads.emplace_back([&pentagon] {
+                EXPECT_DOUBLE_EQ(pentagon->getArea(), 5.0);
+                EXPECT_EQ(pentagon->getCenter(), Point<double>(1, 1.4));
+                EXPECT_EQ(pentagon->getBoundingBox().hi, Point<double>(2, 3));
+            });
+        for (auto& t : threads)
+            t.join();
+        CachedFigure<double, Pentagon> copy = *pentagon;
+        EXPECT_DOUBLE_EQ(copy.getArea(), 5.0);
+    }
+}
+
+TEST(ValidatorTest, FlagsInvalidFigures) {
+    using P = Point<double>;
+    Array<double> array;
+    array.addFigure(makeRhombus<double>());
+    array.addFigure(makeTrapezoid<double>());
+    array.addFigure(makePentagon<double>());
+    array.addFigure(make_shared<Rhombus<double>>(P(0, 0), P(3, 0), P(3, 1), P(0, 1)));
+    array.addFigure(make_shared<Trapezoid<double>>(P(0, 0), P(4, 0), P(3, 2), P(0, 2)));
+    array.addFigure(make_shared<Trapezoid<double>>(P(0, 0), P(4, 0), P(5, 3), P(0, 1)));
+    array.addFigure(make_shared<Pentagon<double>>(P(0, 0), P(2, 2), P(2, 0), P(0, 2), P(1, 3)));
+    array.addFigure(make_shared<Pentagon<double>>(P(0, 0), P(2, 0), P(1, 1), P(2, 2), P(0, 2)));
+    array.addFigure(make_shared<Rhombus<double>>(P(0, 0), P(1, 1), P(2, 2), P(1, 1)));
+
+    ThreadPool pool(2);
+    BatchValidator<double> validator(pool, 2);
+    auto flags = validator.validate(array);
+    ASSERT_EQ(flags.size(), 9);
+    EXPECT_EQ(flags[0], VALID);
+    EXPECT_EQ(flags[1], VALID);
+    EXPECT_EQ(flags[2], VALID);
+    EXPECT_EQ(flags[3], UNEQUAL_SIDES);
+    EXPECT_EQ(flags[4], NOT_CYCLIC);
+    EXPECT_EQ(flags[5], NOT_TRAPEZOID | NOT_CYCLIC);
+    EXPECT_EQ(flags[6], NOT_CONVEX | NOT_SIMPLE);
+    EXPECT_EQ(flags[7], NOT_CONVEX);
+    EXPECT_TRUE(flags[8] & DEGENERATE);
+
+    auto errors = BatchValidator<double>::errors(flags);
+    ASSERT_EQ(errors.size(), 6);
+    EXPECT_EQ(errors[0].index, 3);
+
+    // Пустая ячейка получает EMPTY, индексы остальных совпадают с Array.
+    array.removeFigure(1, RemovalPolicy::Tombstone);
+    flags = validator.validate(array);
+    ASSERT_EQ(flags.size(), 9);
+    EXPECT_EQ(flags[1], EMPTY);
+    EXPECT_EQ(flags[3], UNEQUAL_SIDES);
+    errors = BatchValidator<double>::errors(flags);
+    ASSERT_EQ(errors.size(), 6);
+    EXPECT_EQ(errors[0].index, 3);
+
+    // Допуски зависят от размера фигуры, а не от её положения.
+    Array<double> far;
+    for (const auto& [dx, dy] : {pair(0.0, 0.0), pair(0.0, 1e6), pair(1e6, -1e6)}) {
+        auto at = [&](double x, double y) { return P(x + dx, y + dy); };
+        far.addFigure(make_shared<Rhombus<double>>(at(0, 0), at(2, 1), at(0, 2), at(-2, 1)));
+        far.addFigure(make_shared<Rhombus<double>>(at(0, 0), at(3, 0), at(3, 2), at(0, 2)));
+    }
+    flags = validator.validate(far);
+    for (size_t i = 0; i < flags.size(); ++i)
+        EXPECT_EQ(flags[i], i % 2 ? UNEQUAL_SIDES : VALID) << i;
+
+    // Больше одного блока, неполный хвост и несколько потоков.
+    Array<double> many;
+    for (int i = 0; i < 150; ++i)
+        many.addFigure(i % 3 ? shared_ptr<Figure<double>>(makePentagon<double>())
+                             : shared_ptr<Figure<double>>(make_shared<Rhombus<double>>(P(0, 0), P(3, 0), P(3, 1), P(0, 1))));
+    BatchValidator<double> blocks(pool, 37);
+    flags = blocks.validate(many);
+    for (size_t i = 0; i < flags.size(); ++i)
+        EXPECT_EQ(flags[i], i % 3 ? VALID : UNEQUAL_SIDES);
+}
+
+TEST(ArrayTest, CopyOnWrite) {
+    Array<double> original;
+    original.setCopyMode(CopyMode::CopyOnWrite);
+    original.addFigure(makeRhombus<double>());
+    original.addFigure(makePentagon<double>());
+
+    Array<double> snapshot = original;
+    EXPECT_TRUE(snapshot.sharesStorage());
+    EXPECT_EQ(snapshot.getFigure(0), original.getFigure(0));
+    EXPECT_EQ(snapshot.getCopyMode(), CopyMode::CopyOnWrite);
+
+    original.addFigure(makeTrapezoid<double>());
+    EXPECT_FALSE(snapshot.sharesStorage());
+    EXPECT_EQ(snapshot.getSize(), 2);
+    EXPECT_EQ(original.getSize(), 3);
+    EXPECT_EQ(snapshot.getFigure(1), original.getFigure(1));
+
+    auto figure = dynamic_pointer_cast<Rhombus<double>>(original.mutableFigure(0));
+    ASSERT_NE(figure, nullptr);
+    EXPECT_NE(figure, snapshot.getFigure(0));
+    figure->setPoint(1, Point<double>(4, 1));
+    EXPECT_DOUBLE_EQ(snapshot.getFigure(0)->getArea(), 4.0);
+    EXPECT_NE(original.getFigure(0)->getArea(), 4.0);
+
+    Array<double> second = snapshot;
+    second.removeFigure(0);
+    EXPECT_EQ(snapshot.getSize(), 2);
+    EXPECT_EQ(second.getSize(), 1);
+    EXPECT_EQ(second.getFigure(0), snapshot.getFigure(1));
+}
+
+TEST(ArrayTest, CopyOnWriteClonesOnEitherSide) {
+    FigureArena<double> arena;
+    Array<double> array;
+    array.setCopyMode(CopyMode::CopyOnWrite);
+    for (int i = 0; i < 3; ++i)
+        array.addFigure(arena.make<Rhombus<double>>(
+            Point<double>(0, 0), Point<double>(2, 1), Point<double>(0, 2), Point<double>(-2, 1)));
+
+    // Копия пишет первой: оригинал всё равно не должен менять общие фигуры.
+    Array<double> snapshot = array;
+    snapshot.removeFigure(2);
+    array.mutableFigure(0)->translate(10, 0);
+    array.transform(Affine2D::scaling(2, 2));
+    EXPECT_EQ(snapshot[0]->getCenter(), Point<double>(0, 1));
+    EXPECT_DOUBLE_EQ(snapshot.getAllArea(), 8.0);
+    EXPECT_EQ(array[0]->getCenter(), Point<double>(20, 2));
+    EXPECT_DOUBLE_EQ(array.getAllArea(), 48.0);
+
+    const Array<double>& source = array;
+    vector<Array<double>> copies(2);
+    thread first([&] { copies[0] = source; });
+    thread second([&] { copies[1] = source; });
+    first.join();
+    second.join();
+    copies[0].mutableFigure(1)->translate(1, 1);
+    EXPECT_EQ(copies[1][1]->getCenter(), array[1]->getCenter());
+    EXPECT_NE(copies[0][1]->getCenter(), array[1]->getCenter());
+    copies.clear();
+    snapshot = Array<double>();
+    array = Array<double>();
+}
+
+TEST(ArrayTest, AddAfterMove) {
+    Array<int> array1;
+    array1.addFigure(makeRhombus<int>());
+    Array<int> array2 = move(array1);
+    array1.addFigure(makePentagon<int>());
+    EXPECT_EQ(array1.getSize(), 1);
+    EXPECT_GE(array1.getCapacity(), 1);
+}
+
+TEST(ConcurrentArrayTest, ParallelAppendAndSnapshots) {
+    ConcurrentArray<double> array;
+    const size_t writers = 4, perWriter = 2000;
+    atomic<bool> done{false};
+    atomic<size_t> snapshots{0};
+
+    thread reader([&] {
+        while (!done.load()) {
+            double area = array.getAllArea();
+            EXPECT_GE(area, 0.0);
+            snapshots++;
+        }
+    });
+    vector<thread> threads;
+    for (size_t w = 0; w < writers; ++w)
+        threads.emplace_back([&array, w] {
+            for (size_t i = 0; i < perWriter; ++i)
+                array.addFigure(w % 2 ? shared_ptr<Figure<double>>(makeRhombus<double>())
+                                      : shared_ptr<Figure<double>>(makePentagon<double>()));
+        });
+    for (auto& t : threads)
+        t.join();
+    done = true;
+    reader.join();
+
+    EXPECT_EQ(array.getSize(), writers * perWriter);
+    EXPECT_DOUBLE_EQ(array.getAllArea(), perWriter * 2 * (4.0 + 5.0));
+    EXPECT_EQ(array.snapshot().getSize(), writers * perWriter);
+    EXPECT_GT(snapshots.load(), 0);
+}
+
+TEST(ConcurrentArrayTest, RemoveWhileReading) {
+    ConcurrentArray<int> array;
+    for (int i = 0; i < 500; ++i)
+        array.addFigure(makeRhombus<int>());
+
+    thread reader([&] {
+        for (int k = 0; k < 200; ++k)
+            for (size_t i = 0; i < array.getSize(); i += 7) {
+                auto figure = array.getFigure(i);
+                if (figure) {
+                    EXPECT_DOUBLE_EQ(figure->getArea(), 4.0);
+                }
+            }
+    });
+    for (size_t i = 0; i < 500; i += 2)
+        EXPECT_TRUE(array.removeFigure(i));
+    reader.join();
+
+    EXPECT_FALSE(array.removeFigure(0));
+    EXPECT_EQ(array.getFigure(0), nullptr);
+    EXPECT_NE(array.getFigure(1), nullptr);
+    EXPECT_EQ(array.snapshot().getSize(), 250);
+}
+
+TEST(ConcurrentArrayTest, GuardsBeyondReaderSlots) {
+    EpochManager epochs;
+    {
+        vector<unique_ptr<EpochManager::Guard>> guards;
+        for (int i = 0; i < 300; ++i)
+            guards.push_back(make_unique<EpochManager::Guard>(epochs));
+        // Читатели без слота не дают сдвинуть эпоху.
+        const uint64_t e = epochs.current();
+        EXPECT_EQ(epochs.tryAdvance(), e);
+    }
+    const uint64_t e = epochs.current();
+    EXPECT_EQ(epochs.tryAdvance(), e + 1);
+}
+
+template <Scalar T>
+string printWithIostream(const Array<T>& array) {
+    ostringstream os;
+    for (size_t i = 0; i < array.getSize(); ++i) {
+        os << "Фигура " << i << ": ";
+        if (array[i]) {
+            array[i]->print(os);
+            os << " | Центр: " << array[i]->getCenter() << " | Площадь: " << static_cast<double>(*array[i]);
+        } else {
+            os << "(пусто)";
+        }
+        os << '\n';
+    }
+    return os.str();
+}
+
+template <Scalar T>
+void checkFormatMatchesIostream() {
+    auto array = makeScene<T>(20);
+    array.addFigure(make_shared<Trapezoid<T>>(
+        Point<T>(static_cast<T>(-2.5), 0), Point<T>(static_cast<T>(123456789), 0),
+        Point<T>(static_cast<T>(1.732), static_cast<T>(0.0001)), Point<T>(static_cast<T>(-1e-7), static_cast<T>(3.3333333))));
+    array.addFigure(nullptr);
+    ostringstream fast;
+    array.printFigures(fast);
+    EXPECT_EQ(fast.str(), printWithIostream(array));
+}
+
+TEST(FigureFormatTest, MatchesIostreamOutput) {
+    checkFormatMatchesIostream<int>();
+    checkFormatMatchesIostream<float>();
+    checkFormatMatchesIostream<double>();
+
+    auto array = makeScene<double>(3);
+    ostringstream precise;
+    precise.precision(12);
+    writeFigures(precise, array);
+    ostringstream expected;
+    expected.precision(12);
+    for (size_t i = 0; i < array.getSize(); ++i) {
+        expected << "Фигура " << i << ": ";
+        array[i]->print(expected);
+        expected << " | Центр: " << array[i]->getCenter() << " | Площадь: " << static_cast<double>(*array[i]) << '\n';
+    }
+    EXPECT_EQ(precise.str(), expected.str());
+}
+
+TEST(FigureFormatTest, CsvAndJsonLines) {
+    Array<double> array;
+    array.addFigure(makeRhombus<double>());
+    array.addFigure(makePentagon<double>());
+
+    ostringstream csv;
+    writeCsv(csv, array);
+    EXPECT_EQ(csv.str(),
+              "index,type,area,center_x,center_y,x1,y1,x2,y2,x3,y3,x4,y4,x5,y5\n"
+              "0,rhombus,4,0,1,0,0,2,1,0,2,-2,1,,\n"
+              "1,pentagon,5,1,1.4,0,0,2,0,2,2,1,3,0,2\n");
+
+    ostringstream json;
+    writeJsonLines(json, array);
+    EXPECT_EQ(json.str(),
+              "{\"index\":0,\"type\":\"rhombus\",\"area\":4,\"center\":[0,1],"
+              "\"points\":[[0,0],[2,1],[0,2],[-2,1]]}\n"
+              "{\"index\":1,\"type\":\"pentagon\",\"area\":5,\"center\":[1,1.4],"
+              "\"points\":[[0,0],[2,0],[2,2],[1,3],[0,2]]}\n");
+}
+
+namespace {
+
+constexpr Rhombus<int> REFERENCE_RHOMBUS{{0, 0}, {2, 1}, {0, 2}, {-2, 1}};
+constexpr Trapezoid<double> REFERENCE_TRAPEZOID{{0, 0}, {4, 0}, {3, 2}, {1, 2}};
+constexpr Pentagon<double> REFERENCE_PENTAGON{{0, 0}, {2, 0}, {2, 2}, {1, 3}, {0, 2}};
+
+static_assert(REFERENCE_RHOMBUS.getArea() == 4.0);
+static_assert(REFERENCE_RHOMBUS.getCenter() == Point<int>(0, 1));
+static_assert(REFERENCE_TRAPEZOID.getArea() == 6.0);
+static_assert(static_cast<double>(REFERENCE_PENTAGON) == 5.0);
+static_assert(REFERENCE_PENTAGON.getBoundingBox().hi == Point<double>(2, 3));
+static_assert(REFERENCE_PENTAGON.kind() == FigureKind::Pentagon);
+constexpr Trapezoid<double> SAME_TRAPEZOID{{0, 0}, {4, 0}, {3, 2}, {1, 2}};
+static_assert(REFERENCE_TRAPEZOID.operator==(SAME_TRAPEZOID));
+static_assert(!REFERENCE_TRAPEZOID.operator==(REFERENCE_PENTAGON));
+
+consteval double referenceTableArea() {
+    Rhombus<double> rhombus({0, 0}, {3, 4}, {6, 0}, {3, -4});
+    Pentagon<double> pentagon = REFERENCE_PENTAGON;
+    const Figure<double>* table[] = {&rhombus, &REFERENCE_TRAPEZOID, &pentagon};
+    double total = 0.0;
+    for (const Figure<double>* figure : table)
+        total += figure->getArea();
+    rhombus.setPoint(2, {6, 0});
+    return total;
+}
+
+static_assert(referenceTableArea() == 24.0 + 6.0 + 5.0);
+static_assert(constexprSqrt(2.0) * constexprSqrt(2.0) - 2.0 < 1e-15);
+
+}
+
+TEST(ConstexprFigureTest, MatchesRuntimeValues) {
+    const Rhombus<int> rhombus = *makeRhombus<int>();
+    EXPECT_EQ(REFERENCE_RHOMBUS.getArea(), rhombus.getArea());
+    EXPECT_TRUE(REFERENCE_RHOMBUS == rhombus);
+    for (double x : {0.0, 1e-300, 0.25, 2.0, 3.0, 1e10, 1e300})
+        EXPECT_NEAR(constexprSqrt(x), sqrt(x), sqrt(x) * 1e-15);
+    EXPECT_EQ(constexprSqrt(16.0), 4.0);
+}
+
+TEST(ExactIntegerTest, AreasCentersAndEquality) {
+    // Диагонали 2 и 4·√2: прежний путь через sqrt в int давал 2 * 5 / 2 = 5 вместо 8.
+    Rhombus<int> rhombus(Point<int>(0, 0), Point<int>(3, 1), Point<int>(2, 4), Point<int>(-1, 3));
+    EXPECT_EQ(rhombus.getArea(), 10.0);
+    EXPECT_EQ(rhombus.doubledArea(), 20);
+
+    const int big = 2000000000;
+    Trapezoid<int> wide(Point<int>(-big, -big), Point<int>(big, -big), Point<int>(big, big), Point<int>(-big, big));
+    EXPECT_TRUE(wide.doubledArea() == int128_t(2) * (int64_t(2) * big) * (int64_t(2) * big));
+
+    const int64_t huge = int64_t(1) << 40;
+    Pentagon<int64_t> pentagon(Point<int64_t>(0, 0), Point<int64_t>(huge, 0), Point<int64_t>(huge, huge),
+                               Point<int64_t>(huge / 2, huge + 1), Point<int64_t>(0, huge));
+    const int128_t expected = int128_t(2) * huge * huge + huge;
+    EXPECT_TRUE(pentagon.doubledArea() == expected);
+
+    auto center = Pentagon<int>(Point<int>(0, 0), Point<int>(2, 0), Point<int>(2, 2),
+                                Point<int>(1, 3), Point<int>(0, 2)).exactCenter();
+    EXPECT_TRUE(center == (RationalPoint<int>{10, 14, 10}));
+    EXPECT_EQ(center.toDouble(), Point<double>(1.0, 1.4));
+
+    // Сумма -6 делится на 4 как int (усечение к нулю), а не через size_t.
+    const Rhombus<int> negative(Point<int>(-3, -2), Point<int>(-1, -1), Point<int>(-1, 0), Point<int>(-1, -1));
+    EXPECT_EQ(negative.getCenter(), Point<int>(-1, -1));
+    EXPECT_EQ(vertexCenter(negative.getPoints(), 4), Point<int>(-1, -1));
+    Array<int> negatives;
+    negatives.addFigure(make_shared<Rhombus<int>>(negative));
+    EXPECT_EQ(FigureStore<int>(negatives).getCenters(), (vector<Point<int>>{Point<int>(-1, -1)}));
+
+    EXPECT_FALSE(Point<int64_t>(huge, 0) == Point<int64_t>(huge + 1, 0));
+    EXPECT_TRUE(Point<double>(1.0, 0.0) == Point<double>(1.0 + 1e-12, 0.0));
+
+    Array<int> array;
+    array.addFigure(make_shared<Rhombus<int>>(rhombus));
+    array.addFigure(make_shared<Trapezoid<int>>(wide));
+    EXPECT_EQ(FigureStore<int>(array).getAreas(), (vector<double>{10.0, 4.0 * big * double(big)}));
+}
+
+TEST(InstrumentationTest, CountersAndJson) {
+    instrumentation::reset();
+    auto& registry = instrumentation::Registry::instance();
+    registry.add(instrumentation::Counter::BytesParsed, 100);
+    registry.record(instrumentation::Operation::Read, 0);
+    registry.record(instrumentation::Operation::Read, 5);
+    registry.record(instrumentation::Operation::Read, 1000);
+
+    Array<double> array(2);
+    array.addFigure(makeRhombus<double>());
+    array.addFigure(makePentagon<double>());
+    array.addFigure(make_shared<CachedFigure<double, Pentagon>>(*makePentagon<double>()));
+    Array<double> copy = array;
+    copy.getAllArea();
+    copy.getAllArea();
+
+    auto s = instrumentation::snapshot();
+    const auto& read = s.histogram(instrumentation::Operation::Read);
+    EXPECT_EQ(read.buckets[0], 1u);
+    EXPECT_EQ(read.buckets[3], 1u);
+    EXPECT_EQ(read.buckets[10], 1u);
+    EXPECT_EQ(read.maxNs, 1000u);
+    EXPECT_EQ(read.percentile(0.5), 7u);
+    if constexpr (instrumentation::enabled) {
+        EXPECT_EQ(s.counter(instrumentation::Counter::BytesParsed), 100u);
+        EXPECT_EQ(s.counter(instrumentation::Counter::Resizes), 1u);
+        EXPECT_EQ(s.counter(instrumentation::Counter::Clones), 3u);
+        EXPECT_EQ(s.counter(instrumentation::Counter::AreaCalls), 6u);
+        EXPECT_EQ(s.counter(instrumentation::Counter::AreaComputations), 5u);
+        EXPECT_EQ(s.histogram(instrumentation::Operation::Clone).count, 3u);
+    } else {
+        EXPECT_EQ(s.counter(instrumentation::Counter::Clones), 0u);
+        EXPECT_EQ(s.counter(instrumentation::Counter::AreaCalls), 0u);
+    }
+
+    ostringstream json;
+    instrumentation::writeJson(json, s);
+    EXPECT_NE(json.str().find("\"read\":{\"count\":3,\"total_ns\":1005,\"max_ns\":1000"), string::npos);
+    EXPECT_NE(json.str().find("{\"upper_ns\":1023,\"count\":1}"), string::npos);
+
+    instrumentation::reset();
+    s = instrumentation::snapshot();
+    EXPECT_EQ(s.counter(instrumentation::Counter::BytesParsed), 0u);
+    EXPECT_EQ(s.histogram(instrumentation::Operation::Read).count, 0u);
+}
+
+TEST(AffineTest, FigureTransformUpdatesCache) {
+    auto pentagon = make_shared<CachedFigure<double, Pentagon>>(*makePentagon<double>());
+    pentagon->getArea();
+    pentagon->getCenter();
+    pentagon->getBoundingBox();
+
+    const auto m = Affine2D::scaling(2.0, 3.0).then(Affine2D::translation(1.0, -1.0));
+    pentagon->transform(m);
+    EXPECT_DOUBLE_EQ(pentagon->getArea(), 30.0);
+    EXPECT_EQ(pentagon->getCenter(), Point<double>(3.0, 3.2));
+    EXPECT_EQ(pentagon->getBoundingBox().hi, Point<double>(5.0, 8.0));
+    EXPECT_DOUBLE_EQ(pentagon->getArea(), pentagon->polygonArea());
+    EXPECT_EQ(pentagon->shape(), Pentagon<double>(Point<double>(1, -1), Point<double>(5, -1), Point<double>(5, 5),
+                                          Point<double>(3, 8), Point<double>(1, 5)));
+
+    auto rhombus = make_shared<CachedFigure<double, Rhombus>>(*makeRhombus<double>());
+    rhombus->getArea();
+    rhombus->rotate(M_PI / 2, Point<double>(0, 1));
+    EXPECT_NEAR(rhombus->getArea(), 4.0, 1e-12);
+    EXPECT_TRUE(rhombus->getPoints()[0] == Point<double>(1, 1));
+    rhombus->scale(2.0, 1.0);
+    EXPECT_DOUBLE_EQ(rhombus->getArea(), Rhombus<double>::diagonalArea(rhombus->getPoints()));
+
+    auto trapezoid = make_shared<CachedFigure<int, Trapezoid>>(*makeTrapezoid<int>());
+    const double area = trapezoid->getArea();
+    trapezoid->translate(3, -2);
+    EXPECT_EQ(trapezoid->getArea(), area);
+    trapezoid->rotate(M_PI / 2);
+    trapezoid->scale(2.0, 2.0);
+    EXPECT_EQ(trapezoid->getArea(), 4 * area);
+    EXPECT_EQ(trapezoid->getPoints()[0], Point<int>(4, 2));
+}
+
+TEST(AffineTest, BulkTransformsMatchPerFigure) {
+    const auto m = Affine2D::rotation(0.3, 1.0, 2.0).then(Affine2D::scaling(1.5, 0.5));
+    for (int pass = 0; pass < 2; ++pass) {
+        auto array = makeScene<double>(101);
+        array.setCopyMode(CopyMode::CopyOnWrite);
+        Array<double> original = array;
+        FigureStore<double> store(array);
+        FigureStore<double> parallelStore(array);
+
+        ThreadPool pool(3);
+        if (pass == 0)
+            array.transform(m);
+        else
+            array.transform(m, pool, 7);
+        store.transform(m);
+        parallelStore.transform(m, pool, 5);
+
+        EXPECT_EQ(original[0]->getPoints()[1], Point<double>(1, 1));
+        for (size_t i = 0; i < array.getSize(); ++i) {
+            Point<double> expected[5];
+            for (size_t k = 0; k < original[i]->getSize(); ++k)
+                expected[k] = m.apply(original[i]->getPoints()[k]);
+            for (size_t k = 0; k < original[i]->getSize(); ++k)
+                EXPECT_EQ(memcmp(&array[i]->getPoints()[k], &expected[k], sizeof(Point<double>)), 0);
+        }
+        Array<double> fromStore = store.toArray();
+        Array<double> fromParallel = parallelStore.toArray();
+        for (size_t i = 0; i < array.getSize(); ++i) {
+            EXPECT_EQ(memcmp(fromStore[i]->getPoints(), array[i]->getPoints(), array[i]->getSize() * sizeof(Point<double>)), 0);
+            EXPECT_EQ(memcmp(fromParallel[i]->getPoints(), array[i]->getPoints(), array[i]->getSize() * sizeof(Point<double>)), 0);
+        }
+    }
+
+    vector<float> xs(13), ys(13), sx, sy;
+    for (size_t i = 0; i < xs.size(); ++i) {
+        xs[i] = 0.1f * i;
+        ys[i] = 1.0f - 0.3f * i;
+    }
+    sx = xs;
+    sy = ys;
+    batchAffine(xs.data(), ys.data(), xs.size(), m);
+    batchAffine(sx.data(), sy.data(), sx.size(), m, SimdLevel::Scalar);
+    EXPECT_EQ(xs, sx);
+    EXPECT_EQ(ys, sy);
+}
+
+TEST(CollisionTest, MatchesBruteForce) {
+    Rhombus<double> a(Point<double>(0, 0), Point<double>(2, 1), Point<double>(0, 2), Point<double>(-2, 1));
+    Rhombus<double> touching(Point<double>(4, 0), Point<double>(6, 1), Point<double>(4, 2), Point<double>(2, 1));
+    Rhombus<double> diagonalGap(Point<double>(2, 2), Point<double>(4, 3), Point<double>(2, 4), Point<double>(0, 3));
+    EXPECT_TRUE(figuresIntersect<double>(a, touching));
+    EXPECT_TRUE(a.getBoundingBox().intersects(diagonalGap.getBoundingBox()));
+    EXPECT_FALSE(figuresIntersect<double>(a, diagonalGap));
+
+    Array<double> array;
+    for (int i = 0; i < 400; ++i) {
+        const double x = (i * 37 % 101) * 0.7, y = (i * 53 % 89) * 0.4;
+        const double s = 0.5 + (i % 5) * 0.4;
+        switch (i % 3) {
+            case 0:
+                array.addFigure(make_shared<Rhombus<double>>(Point<double>(x, y - s), Point<double>(x + s, y),
+                                                            Point<double>(x, y + s), Point<double>(x - s, y)));
+                break;
+            case 1:
+                array.addFigure(make_shared<Trapezoid<double>>(Point<double>(x - s, y), Point<double>(x + s, y),
+                                                              Point<double>(x + 1, y + s), Point<double>(x - 1, y + s)));
+                break;
+            default:
+                array.addFigure(make_shared<Pentagon<double>>(Point<double>(x, y), Point<double>(x + s, y),
+                                                             Point<double>(x + s, y + s), Point<double>(x + s / 2, y + 1.5 * s),
+                                                             Point<double>(x, y + s)));
+                break;
+        }
+        if (i % 50 == 7) array.addFigure(nullptr);
+    }
+
+    vector<pair<size_t, size_t>> expected;
+    for (size_t i = 0; i < array.getSize(); ++i)
+        for (size_t j = i + 1; j < array.getSize(); ++j)
+            if (array[i] && array[j] && figuresIntersect(*array[i], *array[j]))
+                expected.emplace_back(i, j);
+    ASSERT_FALSE(expected.empty());
+
+    ThreadPool pool(4);
+    EXPECT_EQ(CollisionDetector<double>(pool, 16).findPairs(array), expected);
+    EXPECT_EQ(CollisionDetector<double>(pool, 100000).findPairs(array), expected);
+    EXPECT_TRUE(CollisionDetector<int>().findPairs(Array<int>()).empty());
+}
+
+TEST(DedupTest, GroupsNearDuplicates) {
+    Array<double> array;
+    array.addFigure(makeRhombus<double>());
+    array.addFigure(makePentagon<double>());
+    // Отличие 4e-10 через границу ячейки квантования 1e-6.
+    array.addFigure(make_shared<Rhombus<double>>(Point<double>(0, 0), Point<double>(2, 1),
+                                                 Point<double>(1e-6 - 2e-10, 2), Point<double>(-2, 1)));
+    array.addFigure(make_shared<Rhombus<double>>(Point<double>(0, 0), Point<double>(2, 1),
+                                                 Point<double>(1e-6 + 2e-10, 2), Point<double>(-2, 1)));
+    array.addFigure(nullptr);
+    array.addFigure(make_shared<Trapezoid<double>>(Point<double>(0, 0), Point<double>(2, 1),
+                                                   Point<double>(0, 2), Point<double>(-2, 1)));
+    array.addFigure(makePentagon<double>());
+    array.addFigure(make_shared<Rhombus<double>>(Point<double>(0, 0), Point<double>(2, 1),
+                                                 Point<double>(0, 2 + 2e-9), Point<double>(-2, 1)));
+
+    ThreadPool pool(3);
+    Deduplicator<double> dedup(pool, 4, 2);
+    const DedupResult result = dedup.group(array);
+    EXPECT_EQ(result.representative, (vector<size_t>{0, 1, 2, 2, 4, 5, 1, 7}));
+    EXPECT_EQ(result.unique, (vector<size_t>{0, 1, 2, 5, 7}));
+    EXPECT_EQ(result.duplicates, 2u);
+
+    for (size_t i = 0; i < array.getSize(); ++i)
+        for (size_t j = 0; j < i; ++j)
+            if (array[i] && array[j] && result.representative[j] == j && *array[i] == *array[j]) {
+                EXPECT_EQ(result.representative[i], j);
+                break;
+            }
+
+    EXPECT_EQ(dedup.unique(array).getSize(), 5u);
+    EXPECT_EQ(dedup.shareDuplicates(array), 2u);
+    EXPECT_EQ(array[6].get(), array[1].get());
+    array.mutableFigure(6)->translate(1, 0);
+    EXPECT_EQ(array[1]->getPoints()[0], Point<double>(0, 0));
+    array.mutableFigure(2)->translate(1, 0);
+    EXPECT_EQ(array[3]->getPoints()[0], Point<double>(0, 0));
+
+    // Представитель и его дубликаты сдвигаются ровно один раз каждый.
+    Array<double> copies;
+    for (int i = 0; i < 3; ++i)
+        copies.addFigure(makeRhombus<double>());
+    EXPECT_EQ(dedup.shareDuplicates(copies), 2u);
+    copies.transform(Affine2D::translation(10, 0));
+    for (size_t i = 0; i < copies.getSize(); ++i)
+        EXPECT_EQ(copies[i]->getPoints()[0], Point<double>(10, 0)) << i;
+
+    // При больших координатах смещение внутри ячейки нельзя считать как v - q * CELL.
+    Array<double> large;
+    for (double x : {7510422.2629489992, 7510422.2629489983}) {
+        const Point<double> p(x, 1.0);
+        large.addFigure(make_shared<Rhombus<double>>(p, Point<double>(x + 2, 2), Point<double>(x, 3), Point<double>(x - 2, 2)));
+    }
+    ASSERT_TRUE(*large[0] == *large[1]);
+    EXPECT_EQ(Deduplicator<double>(pool).group(large).duplicates, 1u);
+
+    auto scene = makeScene<int>(300);
+    const DedupResult ints = Deduplicator<int>(pool).group(scene);
+    EXPECT_EQ(ints.unique.size(), 21u);
+    EXPECT_EQ(ints.duplicates, 279u);
+}
+
+TEST(OrderingTest, SortTopKAndIndexedArray) {
+    auto array = makeScene<double>(500);
+    array.addFigure(nullptr);
+    const auto key = byCenterDistance(1.0, 2.0);
+
+    vector<pair<double, size_t>> expected;
+    for (size_t i = 0; i < array.getSize(); ++i)
+        if (array[i])
+            expected.emplace_back(key(*array[i]), i);
+    sort(expected.begin(), expected.end());
+
+    ThreadPool pool(4);
+    for (size_t grain : {size_t(7), SORT_GRAIN}) {
+        const auto order = sortedIndices(array, key, false, pool, grain);
+        ASSERT_EQ(order.size(), expected.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            EXPECT_EQ(order[i], expected[i].second);
+    }
+
+    const auto largest = topK(array, 5, byArea, true, pool, 16);
+    const auto descending = sortedIndices(array, byArea, true, pool, 16);
+    EXPECT_EQ(largest, vector<size_t>(descending.begin(), descending.begin() + 5));
+    double maxArea = 0.0;
+    for (const auto& figure : array)
+        if (figure) maxArea = max(maxArea, figure->getArea());
+    EXPECT_EQ(array[largest[0]]->getArea(), maxArea);
+    EXPECT_EQ(topK(array, 3, key, false, pool), (vector<size_t>{expected[0].second, expected[1].second, expected[2].second}));
+    EXPECT_EQ(topK(array, 10000, byArea).size(), 500u);
+    EXPECT_EQ(nthIndex(array, 42, key, pool, 16), expected[42].second);
+    EXPECT_THROW(nthIndex(array, 500, key), runtime_error);
+
+    array.removeFigure(3, RemovalPolicy::Tombstone);
+    array.setGrowthPolicy(GrowthPolicy::chunked(64));
+    const size_t capacity = array.getCapacity();
+    sortFigures(array, byArea, false, pool, 16);
+    EXPECT_EQ(array.getSize(), 501u);
+    EXPECT_FALSE(array[499]);
+    EXPECT_FALSE(array[500]);
+    for (size_t i = 1; i < 499; ++i)
+        EXPECT_LE(array[i - 1]->getArea(), array[i]->getArea());
+    EXPECT_EQ(array.getTombstoneCount(), 1u);
+    EXPECT_EQ(array.getGrowthPolicy().chunk, 64u);
+    EXPECT_EQ(array.getCapacity(), capacity);
+    EXPECT_EQ(array.compact(), 2u);
+    EXPECT_THROW(array.permute({0, 0}), runtime_error);
+
+    auto scene = makeScene<double>(9);
+    vector<double> areas;
+    for (const auto& figure : scene)
+        areas.push_back(figure->getArea());
+    IndexedArray<double> indexed(scene);
+    EXPECT_EQ(indexed.top(2)[0]->getArea(), *max_element(areas.begin(), areas.end()));
+    indexed.removeFigure(0);
+    indexed.addFigure(make_shared<Rhombus<double>>(Point<double>(0, 0), Point<double>(10, 5),
+                                                   Point<double>(0, 10), Point<double>(-10, 5)));
+    EXPECT_EQ(indexed.getSize(), 9u);
+    EXPECT_EQ(indexed.top(1)[0]->getArea(), 100.0);
+    EXPECT_EQ(indexed.nth(0)->getArea(), indexed.begin()->first);
+    double previous = 0.0;
+    size_t count = 0;
+    for (const auto& [area, figure] : indexed) {
+        EXPECT_LE(previous, area);
+        EXPECT_EQ(area, figure->getArea());
+        previous = area;
+        ++count;
+    }
+    EXPECT_EQ(count, 9u);
+    areas.erase(areas.begin());
+    EXPECT_EQ(indexed.range(4.0, 9.0).size(), size_t(count_if(areas.begin(), areas.end(),
+                                                               [](double a) { return 4.0 <= a && a <= 9.0; })));
+    EXPECT_FALSE(indexed.nth(9));
+}
+
+TEST(ArrayTest, ReserveGrowthAndBulkAdd) {
+    Array<double> array;
+    array.reserve(10);
+    EXPECT_EQ(array.getCapacity(), 10u);
+    array.reserve(3);
+    EXPECT_EQ(array.getCapacity(), 10u);
+
+    vector<shared_ptr<Figure<double>>> figures;
+    for (int i = 0; i < 25; ++i)
+        figures.push_back(makeRhombus<double>());
+    array.addFigures(figures);
+    EXPECT_EQ(array.getSize(), 25u);
+    EXPECT_EQ(array.getCapacity(), 25u);
+    array.addFigure(makePentagon<double>());
+    EXPECT_EQ(array.getCapacity(), 50u);
+    array.shrinkToFit();
+    EXPECT_EQ(array.getCapacity(), 26u);
+    EXPECT_DOUBLE_EQ(array.getAllArea(), 25 * 4.0 + 5.0);
+
+    Array<double> chunked(0);
+    chunked.setGrowthPolicy(GrowthPolicy::chunked(8));
+    for (int i = 0; i < 9; ++i)
+        chunked.addFigure(makeTrapezoid<double>());
+    EXPECT_EQ(chunked.getCapacity(), 16u);
+    chunked.addFigures(figures);
+    EXPECT_EQ(chunked.getCapacity(), 40u);
+
+    Array<double> slow(1);
+    slow.setGrowthPolicy(GrowthPolicy::geometric(1.5));
+    for (int i = 0; i < 4; ++i)
+        slow.addFigure(makeTrapezoid<double>());
+    EXPECT_EQ(slow.getCapacity(), 4u);
+    Array<double> copy = slow;
+    copy.addFigure(makeTrapezoid<double>());
+    EXPECT_EQ(copy.getCapacity(), 6u);
+}
+
+TEST(SegmentedArrayTest, NeverRelocates) {
+    SegmentedArray<int> array(3);
+    EXPECT_EQ(array.getSegmentSize(), 4u);
+    array.addFigure(makeRhombus<int>());
+    const shared_ptr<Figure<int>>* first = &*array.begin();
+    for (int i = 0; i < 9; ++i)
+        array.addFigure(i % 2 ? shared_ptr<Figure<int>>(makePentagon<int>()) : makeTrapezoid<int>());
+    EXPECT_EQ(&*array.begin(), first);
+    EXPECT_EQ(array.getSize(), 10u);
+    EXPECT_EQ(array.getCapacity(), 12u);
+    EXPECT_DOUBLE_EQ(array.getAllArea(), 4.0 + 5 * 6.0 + 4 * 5.0);
+
+    array.removeFigure(0);
+    array.removeFigure(0);
+    array.removeFigure(0);
+    EXPECT_EQ(array.getSize(), 7u);
+    array.shrinkToFit();
+    EXPECT_EQ(array.getSegmentCount(), 2u);
+    EXPECT_EQ(array[0]->kind(), FigureKind::Trapezoid);
+    EXPECT_FALSE(array[7]);
+
+    SegmentedArray<int> copy = array;
+    EXPECT_NE(copy[0].get(), array[0].get());
+    EXPECT_TRUE(*copy[0] == *array[0]);
+
+    Array<int> flat = copy.toArray();
+    ostringstream a, b;
+    flat.printFigures(a);
+    copy.printFigures(b);
+    EXPECT_EQ(a.str(), b.str());
+    EXPECT_EQ(SegmentedArray<int>(flat, 2).getSize(), 7u);
+}
+
+TEST(ArrayTest, EmplaceAndUniqueOwnership) {
+    Array<int> array(1);
+    Rhombus<int>& rhombus = array.emplaceFigure<Rhombus<int>>(Point<int>(0, 0), Point<int>(2, 1),
+                                                              Point<int>(0, 2), Point<int>(-2, 1));
+    EXPECT_EQ(&rhombus, array[0].get());
+    EXPECT_EQ(array[0].use_count(), 2);
+
+    array.addFigure(make_unique<Pentagon<int>>(Point<int>(0, 0), Point<int>(2, 0), Point<int>(2, 2),
+                                               Point<int>(1, 3), Point<int>(0, 2)));
+    unique_ptr<Figure<int>> owned = makeTrapezoid<int>()->clone();
+    const Figure<int>* raw = owned.get();
+    array.addFigure(move(owned));
+    EXPECT_EQ(array[2].get(), raw);
+
+    shared_ptr<Figure<int>> shared = makeRhombus<int>();
+    array.addFigure(move(shared));
+    EXPECT_FALSE(shared);
+    EXPECT_EQ(array[3].use_count(), 2);
+    array.addFigure(nullptr);
+    EXPECT_EQ(array.getSize(), 5u);
+    EXPECT_DOUBLE_EQ(array.getAllArea(), 4.0 + 5.0 + 6.0 + 4.0);
+
+    SegmentedArray<int> segmented(2);
+    segmented.emplaceFigure<Trapezoid<int>>(Point<int>(-2, 0), Point<int>(2, 0), Point<int>(1, 2), Point<int>(-1, 2));
+    segmented.addFigure(make_unique<Rhombus<int>>(rhombus));
+    EXPECT_DOUBLE_EQ(segmented.getAllArea(), 6.0 + 4.0);
+
+    VariantArray<double> variants;
+    Pentagon<double>& pentagon = variants.emplaceFigure<Pentagon<double>>(
+        Point<double>(0, 0), Point<double>(2, 0), Point<double>(2, 2), Point<double>(1, 3), Point<double>(0, 2));
+    EXPECT_EQ(&pentagon, &get<Pentagon<double>>(variants[0]));
+    EXPECT_DOUBLE_EQ(variants.getAllArea(), 5.0);
+}